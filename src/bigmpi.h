@@ -22,6 +22,16 @@ typedef MPI_Aint MPI_Count;
 #define BIGMPI_CONST
 #endif
 
+/* Persistent collectives are part of MPI-4 and an extension of Open MPI before that. */
+#if MPI_VERSION >= 4
+#define BIGMPI_HAVE_PERSISTENT_COLLECTIVES 1
+#elif defined(OPEN_MPI) && OPEN_MPI
+#include <mpi-ext.h>
+#if defined(OMPI_HAVE_MPI_EXT_PCOLLREQ) && OMPI_HAVE_MPI_EXT_PCOLLREQ
+#define BIGMPI_HAVE_PERSISTENT_COLLECTIVES 1
+#endif
+#endif
+
 /* This function does the heavy lifting in BigMPI. */
 
 int BigMPI_Type_contiguous(MPI_Aint offset, MPI_Count count, MPI_Datatype oldtype, MPI_Datatype * newtype);
@@ -103,6 +113,28 @@ int MPIX_Iallgather_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datat
 int MPIX_Ialltoall_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
                      void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype, MPI_Comm comm, MPI_Request *request);
 
+/* Node-shared collectives */
+
+/* The result lives in an MPI-3 shared-memory window (one copy per node) that the caller
+ * releases with MPI_Win_free.  baseptr is a void** in disguise, as in MPI_Win_allocate_shared. */
+int MPIX_Bcast_shared_x(BIGMPI_CONST void *buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm,
+                        void *baseptr, MPI_Win *win);
+
+/* Persistent collectives */
+
+#ifdef BIGMPI_HAVE_PERSISTENT_COLLECTIVES
+int MPIX_Bcast_init_x(void *buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm,
+                      MPI_Info info, MPI_Request *request);
+int MPIX_Allgather_init_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                          void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype, MPI_Comm comm,
+                          MPI_Info info, MPI_Request *request);
+int MPIX_Alltoall_init_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                         void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype, MPI_Comm comm,
+                         MPI_Info info, MPI_Request *request);
+int MPIX_Allreduce_init_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                          MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Info info, MPI_Request *request);
+#endif
+
 /* Neighborhood collectives */
 
 int MPIX_Neighbor_allgather_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
@@ -125,6 +157,28 @@ int MPIX_Allreduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
                      MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
 int MPIX_Reduce_scatter_block_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count recvcount,
                                 MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+int MPIX_Reduce_scatter_x(BIGMPI_CONST void *sendbuf, void *recvbuf, const MPI_Count recvcounts[],
+                          MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+int MPIX_Reduce_local_x(BIGMPI_CONST void *inbuf, void *inoutbuf, MPI_Count count,
+                        MPI_Datatype datatype, MPI_Op op);
+int MPIX_Op_create_x(MPI_User_function *user_fn, int commute, MPI_Op *op);
+int MPIX_Op_free_x(MPI_Op *op);
+/* Formats in which MPIX_Allreduce_x may move sums of MPI_DOUBLE or MPI_FLOAT (see README.md). */
+#define MPIX_WIRE_FULL     0
+#define MPIX_WIRE_FLOAT    1
+#define MPIX_WIRE_BFLOAT16 2
+int MPIX_Comm_set_wire_format_x(MPI_Comm comm, int format);
+int MPIX_Scan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+int MPIX_Exscan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+/* An allreduce whose input is handed over in slices as it is produced (see README.md). */
+typedef struct bigmpi_allreduce_stream_s * MPIX_Allreduce_stream;
+int MPIX_Allreduce_stream_begin_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+                                  MPIX_Allreduce_stream *stream);
+int MPIX_Allreduce_stream_push_x(MPIX_Allreduce_stream stream, MPI_Count offset, MPI_Count count);
+int MPIX_Allreduce_stream_end_x(MPIX_Allreduce_stream *stream);
 #if MPI_VERSION >= 3
 int MPIX_Ireduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
                    MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm, MPI_Request *request);
@@ -132,6 +186,12 @@ int MPIX_Iallreduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count
                       MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request);
 int MPIX_Ireduce_scatter_block_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count recvcount,
                                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request);
+int MPIX_Ireduce_scatter_x(BIGMPI_CONST void *sendbuf, void *recvbuf, const MPI_Count recvcounts[],
+                           MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request);
+int MPIX_Iscan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                 MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request);
+int MPIX_Iexscan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                   MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request);
 #endif
 
 /* RMA */
@@ -195,22 +255,6 @@ int MPIX_Neighbor_alltoallw_x(BIGMPI_CONST void *sendbuf, const MPI_Count sendco
 
 /* UNSUPPORTED */
 
-/* These are equivalent to reduce+scatterv and will likely be supported in the future. */
-
-int MPIX_Reduce_scatter_x(BIGMPI_CONST void *sendbuf, void *recvbuf, const MPI_Count recvcounts[],
-                          MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
-int MPIX_Ireduce_scatter_x(BIGMPI_CONST void *sendbuf, void *recvbuf, const MPI_Count recvcounts[],
-                           MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request);
-
-/* It is unclear if supporting these is worthwhile... */
-
-int MPIX_Scan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
-int MPIX_Exscan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
-int MPIX_Iscan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
-                 MPI_Request *request);
-int MPIX_Iexscan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
-                   MPI_Request *request);
-
 /* Nonblocking V-collectives */
 
 /* These are really hard, if not impossible to support, because the argument vectors
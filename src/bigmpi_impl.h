@@ -31,6 +31,81 @@ void BigMPI_Error_impl(const char *file, const int line, const char *func, const
 
 #define BigMPI_Error(...) BigMPI_Error_impl(__FILE__,__LINE__,__func__,__VA_ARGS__)
 
+void BigMPI_Atfinalize(void (*fn)(void));
+
+MPI_Op BigMPI_Op_get_cached(MPI_Op op);
+
+/* Internal state that BigMPI caches on every communicator it is used with (see context.c). */
+typedef struct {
+    int        size;          /* size of the user communicator */
+    MPI_Comm   dup;           /* private duplicate, used for all internal messages */
+    MPI_Comm   node;          /* processes that can share memory with this one */
+    MPI_Comm   leaders;       /* lowest rank of every node (MPI_COMM_NULL elsewhere) */
+    int      * leader_of;     /* rank in leaders of the node leader of every rank */
+    int      * ring;          /* ring of all ranks that visits every node in one stretch */
+    int        ring_pos;      /* position of this process in ring */
+    MPI_Comm   graph_all;     /* fully connected graph for the all___ v-collectives */
+    MPI_Comm * graph_root;    /* graph for every root of the rooted v-collectives */
+    void     * scratch;       /* scratch buffer reused by blocking collectives */
+    MPI_Aint   scratch_size;
+    MPI_Comm * stripes;       /* duplicates that carry the stripes of large collectives */
+    int        tag;           /* last tag handed out by BigMPI_Get_schedule_tag */
+    int        wire;          /* wire format of large sums (see MPIX_Comm_set_wire_format_x) */
+} bigmpi_context_t;
+
+bigmpi_context_t * BigMPI_Get_context(MPI_Comm comm);
+bigmpi_context_t * BigMPI_Find_context(MPI_Comm comm);
+void * BigMPI_Get_scratch(bigmpi_context_t * ctx, MPI_Aint bytes);
+int BigMPI_Get_schedule_tag(bigmpi_context_t * ctx);
+const int * BigMPI_Get_int_counts(MPI_Comm comm, const MPI_Count counts[]);
+#if MPI_VERSION >= 3
+MPI_Comm BigMPI_Get_graph_comm(bigmpi_context_t * ctx, int root);
+int BigMPI_Get_stripes(MPI_Count count, MPI_Datatype datatype);
+MPI_Comm * BigMPI_Get_stripe_comms(bigmpi_context_t * ctx);
+#endif
+
+/* A nonblocking operation that BigMPI completes through a generalized request (see progress.c). */
+typedef struct bigmpi_request_s bigmpi_request_t;
+
+/* Called once all reqs have completed.  Returns 1 if the operation is done
+ * and 0 if it has posted new requests into reqs. */
+typedef int bigmpi_progress_fn_t(bigmpi_request_t * req);
+
+struct bigmpi_request_s {
+    MPI_Request            greq;      /* generalized request handed to the user */
+    int                    nreqs;
+    MPI_Request          * reqs;      /* MPI requests currently in flight */
+    bigmpi_progress_fn_t * progress;  /* may be NULL */
+    void                 * state;     /* malloc'ed state of progress, freed on completion */
+    void                 * tempbuf;   /* MPI_Alloc_mem'ed buffer, freed on completion */
+    int                    done;
+    bigmpi_request_t     * next;
+};
+
+int BigMPI_Async_progress(void);
+MPI_Aint BigMPI_Get_pipeline_chunk(void);
+int BigMPI_Get_pipeline_depth(void);
+bigmpi_request_t * BigMPI_Request_create(int nreqs);
+int BigMPI_Request_start(bigmpi_request_t * req, MPI_Request * request);
+void BigMPI_Request_wait(bigmpi_request_t * req);
+
+/* Called once a native nonblocking operation has completed (see BigMPI_Type_free_on_completion). */
+typedef void bigmpi_completion_fn_t(void * state);
+
+int BigMPI_Type_free_on_completion(MPI_Datatype * type, MPI_Request * request,
+                                   bigmpi_completion_fn_t * fn, void * state);
+
+#ifdef BIGMPI_HAVE_PERSISTENT_COLLECTIVES
+/* The native persistent collectives, e.g. BIGMPI_PCOLL(Bcast_init). */
+#if MPI_VERSION >= 4
+#define BIGMPI_PCOLL(name) MPI_##name
+#else
+#define BIGMPI_PCOLL(name) MPIX_##name
+#endif
+/* Only for the *_init_x functions, see type_contiguous_x.c. */
+MPI_Datatype BigMPI_Type_contiguous_cached(MPI_Count count, MPI_Datatype oldtype);
+#endif
+
 void BigMPI_Convert_vectors(int                num,
                             int                splat_old_count,
                             const MPI_Count    oldcount,
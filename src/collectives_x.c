@@ -1,9 +1,421 @@
 #include "bigmpi_impl.h"
 
+#if MPI_VERSION >= 3
+
+typedef enum { BIGMPI_IBCAST,
+               BIGMPI_IGATHER,
+               BIGMPI_ISCATTER,
+               BIGMPI_IALLGATHER,
+               BIGMPI_IALLTOALL } bigmpi_icollective_t;
+
+/* n elements of type, resized so that consecutive instances are stride bytes apart. */
+static void BigMPI_Type_chunk(int n, MPI_Datatype type, MPI_Aint stride, MPI_Datatype * newtype)
+{
+    MPI_Datatype tmptype;
+    MPI_Aint lb, extent;
+    MPI_Type_contiguous(n, type, &tmptype);
+    MPI_Type_get_extent(tmptype, &lb, &extent);
+    MPI_Type_create_resized(tmptype, lb, stride, newtype);
+    MPI_Type_commit(newtype);
+    MPI_Type_free(&tmptype);
+}
+
+/* Merges the predefined datatypes that the type signature of type consists of into *basic,
+ * which is MPI_DATATYPE_NULL before the first one.  Returns 0 if they are not all the same. */
+static int BigMPI_Type_merge_basic(MPI_Datatype type, MPI_Datatype * basic)
+{
+    int size;
+    MPI_Type_size(type, &size);
+    if (size==0) {
+        return 1;
+    }
+
+    int nint, nadd, ndts, combiner;
+    MPI_Type_get_envelope(type, &nint, &nadd, &ndts, &combiner);
+
+    if (combiner==MPI_COMBINER_NAMED || ndts==0) {
+        /* Of the predefined pairs of MPI_MINLOC and MPI_MAXLOC, only MPI_2INT repeats one datatype. */
+        if (type==MPI_2INT) {
+            type = MPI_INT;
+        } else if (type==MPI_FLOAT_INT || type==MPI_DOUBLE_INT || type==MPI_LONG_INT ||
+                   type==MPI_SHORT_INT || type==MPI_LONG_DOUBLE_INT) {
+            return 0;
+        }
+        if (*basic==MPI_DATATYPE_NULL) {
+            *basic = type;
+        }
+        return (*basic==type);
+    }
+
+    int          * ints = malloc((nint>0 ? nint : 1)*sizeof(int));      assert(ints!=NULL);
+    MPI_Aint     * adds = malloc((nadd>0 ? nadd : 1)*sizeof(MPI_Aint)); assert(adds!=NULL);
+    MPI_Datatype * dts  = malloc(ndts*sizeof(MPI_Datatype));            assert(dts!=NULL);
+    MPI_Type_get_contents(type, nint, nadd, ndts, ints, adds, dts);
+
+    int same = 1;
+    for (int i=0; i<ndts; i++) {
+        /* Members of a struct without elements do not contribute to the signature. */
+        if (same && !(combiner==MPI_COMBINER_STRUCT && ints[1+i]==0)) {
+            same = BigMPI_Type_merge_basic(dts[i], basic);
+        }
+        int n, c;
+        MPI_Type_get_envelope(dts[i], &n, &n, &n, &c);
+        if (c!=MPI_COMBINER_NAMED) {
+            MPI_Type_free(&dts[i]);
+        }
+    }
+    free(ints);
+    free(adds);
+    free(dts);
+    return same;
+}
+
+/* The predefined datatype that the type signature of type repeats, or MPI_DATATYPE_NULL if
+ * the signature mixes several of them.  Only the signature matters, so all processes of a
+ * collective get the same answer, whatever datatypes they pass. */
+static MPI_Datatype BigMPI_Type_get_basic(MPI_Datatype type)
+{
+    MPI_Datatype basic = MPI_DATATYPE_NULL;
+    return BigMPI_Type_merge_basic(type, &basic) ? basic : MPI_DATATYPE_NULL;
+}
+
+/* Which halves of the argument list of coll are significant at this process,
+ * and whether their chunks are strided over the blocks of all processes. */
+static void BigMPI_Icollective_sides(bigmpi_icollective_t coll, const void * sendbuf, const void * recvbuf,
+                                     int rank, int root, int * use_send, int * use_recv,
+                                     int * strided_send, int * strided_recv)
+{
+    *use_send = *use_recv = *strided_send = *strided_recv = 0;
+    switch (coll) {
+        case BIGMPI_IBCAST:
+            *use_recv = 1;
+            break;
+        case BIGMPI_IGATHER:
+            *use_send = !(rank==root && sendbuf==MPI_IN_PLACE);
+            *use_recv = (rank==root);
+            *strided_recv = 1;
+            break;
+        case BIGMPI_ISCATTER:
+            *use_send = (rank==root);
+            *use_recv = !(rank==root && recvbuf==MPI_IN_PLACE);
+            *strided_send = 1;
+            break;
+        case BIGMPI_IALLGATHER:
+            *use_send = (sendbuf!=MPI_IN_PLACE);
+            *use_recv = 1;
+            *strided_recv = 1;
+            break;
+        case BIGMPI_IALLTOALL:
+            *use_send = (sendbuf!=MPI_IN_PLACE);
+            *use_recv = 1;
+            *strided_send = 1;
+            *strided_recv = 1;
+            break;
+    }
+}
+
+/* One significant half of the argument list of a chunked collective.  The chunks are
+ * counted in elements of type, which is either the datatype of the user or the basic
+ * datatype of a contiguous copy of the user's buffer in the tempbuf of the request. */
+typedef struct {
+    char       * buf;
+    MPI_Datatype type;
+    int          size;
+    MPI_Aint     extent;
+    MPI_Aint     stride;    /* bytes from one block to the next */
+} bigmpi_chunk_side_t;
+
+static int BigMPI_Chunk_side_init(bigmpi_chunk_side_t * side, const void * buf, MPI_Count count,
+                                  MPI_Datatype type, MPI_Count nblocks, MPI_Datatype basic, char * staged)
+{
+    MPI_Aint lb;
+    MPI_Type_size(type, &side->size);
+    MPI_Type_get_extent(type, &lb, &side->extent);
+    side->buf    = (char*)buf;
+    side->type   = type;
+    side->stride = count*side->extent;
+    if (staged==NULL) {
+        return MPI_SUCCESS;
+    }
+
+    MPI_Count bytes = nblocks*count*side->size;
+    side->buf    = staged;
+    side->type   = basic;
+    side->stride = count*side->size;
+    MPI_Type_size(basic, &side->size);
+    side->extent = side->size;
+    return MPIX_Sendrecv_x(buf, nblocks*count, type, 0 /* dest */, 0 /* tag */,
+                           staged, bytes/side->size, basic, 0 /* source */, 0 /* tag */,
+                           MPI_COMM_SELF, MPI_STATUS_IGNORE);
+}
+
+/* Copies a staged receive buffer back into the buffer of the user. */
+typedef struct {
+    void       * recvbuf;
+    MPI_Count    count;     /* elements of recvtype in all blocks */
+    MPI_Datatype recvtype;  /* a duplicate, in case the user frees recvtype before completion */
+    void       * staged;
+    MPI_Datatype basic;
+} bigmpi_unstage_t;
+
+static int BigMPI_Icollective_unstage(bigmpi_request_t * req)
+{
+    bigmpi_unstage_t * s = req->state;
+    int size, basicsize;
+    MPI_Type_size(s->recvtype, &size);
+    MPI_Type_size(s->basic, &basicsize);
+    MPIX_Sendrecv_x(s->staged, s->count*size/basicsize, s->basic, 0 /* dest */, 0 /* tag */,
+                    s->recvbuf, s->count, s->recvtype, 0 /* source */, 0 /* tag */,
+                    MPI_COMM_SELF, MPI_STATUS_IGNORE);
+    MPI_Type_free(&s->recvtype);
+    return 1;
+}
+
+/*
+ * Synopsis
+ *
+ * int BigMPI_Icollective_chunked(bigmpi_icollective_t coll,
+ *                                const void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+ *                                void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+ *                                int root, int ncomms, const MPI_Comm comms[],
+ *                                MPI_Aint chunkbytes, int minchunks, bigmpi_request_t ** req)
+ *
+ *  Input Parameters
+ *
+ *   coll               which collective to perform (the buffer of a broadcast is recvbuf)
+ *   ncomms, comms      communicators that the chunks are distributed over round-robin
+ *   chunkbytes         maximum size of one chunk in bytes (0 means no limit)
+ *   minchunks          minimum number of chunks
+ *   all others         as in the corresponding MPI function
+ *
+ * Output Parameters
+ *
+ *   req                BigMPI request that holds one MPI request per chunk
+ *
+ * Notes
+ *
+ *   Every chunk is a native nonblocking collective with an int count.  All chunks
+ *   are started here, so that they are ordered like any other collective on comms.
+ *
+ *   The processes may pass datatypes of different sizes as long as their signatures
+ *   match, so they cannot agree on chunks of a number of elements.  Instead, the type
+ *   signature of one block has to repeat a single predefined datatype (the caller
+ *   checks BigMPI_Type_get_basic), and the chunk is a power-of-two number of elements
+ *   of that basic datatype, which only depends on data that all processes agree on.
+ *   A process whose datatype does not divide the chunk (e.g. a struct of three ints)
+ *   cannot cut its buffer there, so it copies the buffer into a contiguous array of
+ *   the basic datatype first (and back after completion, if it receives into it).
+ *
+ */
+static int BigMPI_Icollective_chunked(bigmpi_icollective_t coll,
+                                      const void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                                      void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+                                      int root, int ncomms, const MPI_Comm comms[],
+                                      MPI_Aint chunkbytes, int minchunks, bigmpi_request_t ** req)
+{
+    int rank, size;
+    MPI_Comm_rank(comms[0], &rank);
+    MPI_Comm_size(comms[0], &size);
+
+    int use_send, use_recv, strided_send, strided_recv;
+    BigMPI_Icollective_sides(coll, sendbuf, recvbuf, rank, root, &use_send, &use_recv, &strided_send, &strided_recv);
+
+    int sendsize = 0, recvsize = 0;
+    if (use_send) MPI_Type_size(sendtype, &sendsize);
+    if (use_recv) MPI_Type_size(recvtype, &recvsize);
+
+    /* Bytes of the type signature of one block, which are the same on both sides. */
+    MPI_Count bytes = use_send ? sendcount*sendsize : recvcount*recvsize;
+
+    MPI_Datatype basic = BigMPI_Type_get_basic(use_send ? sendtype : recvtype);
+    int basicsize;
+    MPI_Type_size(basic, &basicsize);
+
+    /* The largest power-of-two multiple of the basic datatype that is neither larger than any
+     * of the limits nor larger than bigmpi_int_max, so that no chunk has more than bigmpi_int_max
+     * elements. */
+    MPI_Count limit = bigmpi_int_max;
+    if (chunkbytes>0 && limit > chunkbytes)                 limit = chunkbytes;
+    if (limit > (bytes+minchunks-1)/minchunks)              limit = (bytes+minchunks-1)/minchunks;
+    MPI_Count chunk = basicsize;
+    while (2*chunk <= limit) chunk *= 2;
+
+    int nchunks = (bytes>0) ? (int)((bytes+chunk-1)/chunk) : 1;
+
+    *req = BigMPI_Request_create(nchunks);
+    MPI_Request * reqs = (*req)->reqs;
+
+    /* Stage the sides whose datatype does not divide the chunk. */
+    MPI_Count sendblocks = strided_send ? size : 1;
+    MPI_Count recvblocks = strided_recv ? size : 1;
+    int stage_send = use_send && sendsize>0 && chunk%sendsize!=0;
+    int stage_recv = use_recv && recvsize>0 && chunk%recvsize!=0;
+    MPI_Aint sendstaged = stage_send ? sendblocks*bytes : 0;
+    MPI_Aint recvstaged = stage_recv ? recvblocks*bytes : 0;
+    char * staged = NULL;
+    if (sendstaged+recvstaged > 0) {
+        MPI_Alloc_mem(sendstaged+recvstaged, MPI_INFO_NULL, &staged);
+        assert(staged!=NULL);
+        (*req)->tempbuf = staged;
+    }
+
+    int rc = MPI_SUCCESS;
+    bigmpi_chunk_side_t s, r;
+    if (use_send) {
+        rc = BigMPI_Chunk_side_init(&s, sendbuf, sendcount, sendtype, sendblocks, basic,
+                                    stage_send ? staged : NULL);
+    }
+    if (use_recv && rc==MPI_SUCCESS) {
+        /* The receive buffer is copied in as well, because it holds the input of the root of
+         * a broadcast and of the processes of a collective with MPI_IN_PLACE. */
+        rc = BigMPI_Chunk_side_init(&r, recvbuf, recvcount, recvtype, recvblocks, basic,
+                                    stage_recv ? staged+sendstaged : NULL);
+        if (stage_recv) {
+            bigmpi_unstage_t * u = malloc(sizeof(bigmpi_unstage_t)); assert(u!=NULL);
+            u->recvbuf = recvbuf;
+            u->count   = recvblocks*recvcount;
+            MPI_Type_dup(recvtype, &u->recvtype);
+            u->staged  = staged+sendstaged;
+            u->basic   = basic;
+            (*req)->state    = u;
+            (*req)->progress = BigMPI_Icollective_unstage;
+        }
+    }
+
+    for (int i=0; i<nchunks && rc==MPI_SUCCESS; i++) {
+        MPI_Count offset = (MPI_Count)i*chunk;
+        MPI_Count n = (bytes-offset < chunk) ? bytes-offset : chunk;
+
+        const void * sbuf = sendbuf;
+        int scount = 0;
+        MPI_Datatype stype = sendtype;
+        if (use_send) {
+            sbuf   = s.buf + offset/s.size*s.extent;
+            scount = (int)(n/s.size);
+            stype  = s.type;
+            if (strided_send) {
+                BigMPI_Type_chunk(scount, s.type, s.stride, &stype);
+                scount = 1;
+            }
+        }
+
+        void * rbuf = recvbuf;
+        int rcount = 0;
+        MPI_Datatype rtype = recvtype;
+        if (use_recv) {
+            rbuf   = r.buf + offset/r.size*r.extent;
+            rcount = (int)(n/r.size);
+            rtype  = r.type;
+            if (strided_recv) {
+                BigMPI_Type_chunk(rcount, r.type, r.stride, &rtype);
+                rcount = 1;
+            }
+        }
+
+        switch (coll) {
+            case BIGMPI_IBCAST:
+                rc = MPI_Ibcast(rbuf, rcount, rtype, root, comms[i%ncomms], &reqs[i]);
+                break;
+            case BIGMPI_IGATHER:
+                rc = MPI_Igather(sbuf, scount, stype, rbuf, rcount, rtype, root, comms[i%ncomms], &reqs[i]);
+                break;
+            case BIGMPI_ISCATTER:
+                rc = MPI_Iscatter(sbuf, scount, stype, rbuf, rcount, rtype, root, comms[i%ncomms], &reqs[i]);
+                break;
+            case BIGMPI_IALLGATHER:
+                rc = MPI_Iallgather(sbuf, scount, stype, rbuf, rcount, rtype, comms[i%ncomms], &reqs[i]);
+                break;
+            case BIGMPI_IALLTOALL:
+                rc = MPI_Ialltoall(sbuf, scount, stype, rbuf, rcount, rtype, comms[i%ncomms], &reqs[i]);
+                break;
+        }
+
+        /* Freeing a datatype does not affect pending operations that use it. */
+        if (use_send && strided_send) MPI_Type_free(&stype);
+        if (use_recv && strided_recv) MPI_Type_free(&rtype);
+    }
+
+    return rc;
+}
+
+/*
+ * Returns non-zero if a large nonblocking collective is pipelined, which every process
+ * has to decide the same way, although their counts differ if their datatypes do.  So
+ * the decision only depends on the type signature of one block: it is pipelined if the
+ * signature has more than bigmpi_int_max elements of a single basic datatype.
+ */
+static int BigMPI_Icollective_pipelines(bigmpi_icollective_t coll,
+                                        const void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                                        const void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+                                        int root, MPI_Comm comm)
+{
+    if (!BigMPI_Async_progress()) {
+        return 0;
+    }
+
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    int use_send, use_recv, strided_send, strided_recv;
+    BigMPI_Icollective_sides(coll, sendbuf, recvbuf, rank, root, &use_send, &use_recv, &strided_send, &strided_recv);
+
+    MPI_Count count   = use_send ? sendcount : recvcount;
+    MPI_Datatype type = use_send ? sendtype  : recvtype;
+    int size;
+    MPI_Type_size(type, &size);
+    if (count*size <= bigmpi_int_max) {
+        return 0;
+    }
+
+    MPI_Datatype basic = BigMPI_Type_get_basic(type);
+    if (basic==MPI_DATATYPE_NULL) {
+        return 0;
+    }
+    int basicsize;
+    MPI_Type_size(basic, &basicsize);
+    return (count*size/basicsize > bigmpi_int_max);
+}
+
+/* Pipelines a large nonblocking collective, see progress.c. */
+static int BigMPI_Icollective_pipelined(bigmpi_icollective_t coll,
+                                        const void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                                        void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+                                        int root, MPI_Comm comm, MPI_Request *request)
+{
+    bigmpi_request_t * req;
+    int rc = BigMPI_Icollective_chunked(coll, sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype,
+                                        root, 1, &comm, BigMPI_Get_pipeline_chunk(), 1, &req);
+    BigMPI_Request_start(req, request);
+    return rc;
+}
+
+/* Stripes a large blocking collective over the stripe communicators of comm, see context.c. */
+static int BigMPI_Collective_striped(bigmpi_icollective_t coll,
+                                     const void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                                     void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+                                     int root, MPI_Comm comm, int nstripes)
+{
+    bigmpi_context_t * ctx = BigMPI_Get_context(comm);
+    bigmpi_request_t * req;
+    int rc = BigMPI_Icollective_chunked(coll, sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype,
+                                        root, nstripes, BigMPI_Get_stripe_comms(ctx), 0, nstripes, &req);
+    BigMPI_Request_wait(req);
+    return rc;
+}
+
+#endif
+
 int MPIX_Bcast_x(void *buf, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm)
 {
     int rc = MPI_SUCCESS;
 
+#if MPI_VERSION >= 3
+    int nstripes = BigMPI_Get_stripes(count, datatype);
+    if (nstripes > 1 && BigMPI_Type_get_basic(datatype)!=MPI_DATATYPE_NULL) {
+        return BigMPI_Collective_striped(BIGMPI_IBCAST, NULL, 0, MPI_DATATYPE_NULL,
+                                         buf, count, datatype, root, comm, nstripes);
+    }
+#endif
+
     if (likely (count <= bigmpi_int_max )) {
         rc = MPI_Bcast(buf, (int)count, datatype, root, comm);
     } else {
@@ -24,14 +436,21 @@ int MPIX_Gather_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatype
     if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
         rc = MPI_Gather(sendbuf, (int)sendcount, sendtype, recvbuf, (int)recvcount, recvtype, root, comm);
     } else {
-        MPI_Datatype newsendtype, newrecvtype;
-        BigMPI_Type_contiguous(0,sendcount, sendtype, &newsendtype);
-        BigMPI_Type_contiguous(0,recvcount, recvtype, &newrecvtype);
-        MPI_Type_commit(&newsendtype);
-        MPI_Type_commit(&newrecvtype);
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        /* The root does not send anything with MPI_IN_PLACE and only the root receives. */
+        MPI_Datatype newsendtype = MPI_DATATYPE_NULL, newrecvtype = MPI_DATATYPE_NULL;
+        if (sendbuf!=MPI_IN_PLACE) {
+            BigMPI_Type_contiguous(0,sendcount, sendtype, &newsendtype);
+            MPI_Type_commit(&newsendtype);
+        }
+        if (rank==root) {
+            BigMPI_Type_contiguous(0,recvcount, recvtype, &newrecvtype);
+            MPI_Type_commit(&newrecvtype);
+        }
         rc = MPI_Gather(sendbuf, 1, newsendtype, recvbuf, 1, newrecvtype, root, comm);
-        MPI_Type_free(&newsendtype);
-        MPI_Type_free(&newrecvtype);
+        if (newsendtype!=MPI_DATATYPE_NULL) MPI_Type_free(&newsendtype);
+        if (newrecvtype!=MPI_DATATYPE_NULL) MPI_Type_free(&newrecvtype);
     }
     return rc;
 }
@@ -44,14 +463,21 @@ int MPIX_Scatter_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatype
     if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
         rc = MPI_Scatter(sendbuf, (int)sendcount, sendtype, recvbuf, (int)recvcount, recvtype, root, comm);
     } else {
-        MPI_Datatype newsendtype, newrecvtype;
-        BigMPI_Type_contiguous(0,sendcount, sendtype, &newsendtype);
-        BigMPI_Type_contiguous(0,recvcount, recvtype, &newrecvtype);
-        MPI_Type_commit(&newsendtype);
-        MPI_Type_commit(&newrecvtype);
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        /* Only the root sends and the root does not receive anything with MPI_IN_PLACE. */
+        MPI_Datatype newsendtype = MPI_DATATYPE_NULL, newrecvtype = MPI_DATATYPE_NULL;
+        if (rank==root) {
+            BigMPI_Type_contiguous(0,sendcount, sendtype, &newsendtype);
+            MPI_Type_commit(&newsendtype);
+        }
+        if (recvbuf!=MPI_IN_PLACE) {
+            BigMPI_Type_contiguous(0,recvcount, recvtype, &newrecvtype);
+            MPI_Type_commit(&newrecvtype);
+        }
         rc = MPI_Scatter(sendbuf, 1, newsendtype, recvbuf, 1, newrecvtype, root, comm);
-        MPI_Type_free(&newsendtype);
-        MPI_Type_free(&newrecvtype);
+        if (newsendtype!=MPI_DATATYPE_NULL) MPI_Type_free(&newsendtype);
+        if (newrecvtype!=MPI_DATATYPE_NULL) MPI_Type_free(&newrecvtype);
     }
     return rc;
 }
@@ -61,21 +487,97 @@ int MPIX_Allgather_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Dataty
 {
     int rc = MPI_SUCCESS;
 
+#if MPI_VERSION >= 3
+    int nstripes = BigMPI_Get_stripes(recvcount, recvtype);
+    if (nstripes > 1 && BigMPI_Type_get_basic(recvtype)!=MPI_DATATYPE_NULL) {
+        return BigMPI_Collective_striped(BIGMPI_IALLGATHER, sendbuf, sendcount, sendtype,
+                                         recvbuf, recvcount, recvtype, 0, comm, nstripes);
+    }
+#endif
+
     if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
         rc = MPI_Allgather(sendbuf, (int)sendcount, sendtype, recvbuf, (int)recvcount, recvtype, comm);
     } else {
-        MPI_Datatype newsendtype, newrecvtype;
-        BigMPI_Type_contiguous(0,sendcount, sendtype, &newsendtype);
+        /* With MPI_IN_PLACE, the contribution of every process is already in recvbuf. */
+        MPI_Datatype newsendtype = MPI_DATATYPE_NULL, newrecvtype;
+        if (sendbuf!=MPI_IN_PLACE) {
+            BigMPI_Type_contiguous(0,sendcount, sendtype, &newsendtype);
+            MPI_Type_commit(&newsendtype);
+        }
         BigMPI_Type_contiguous(0,recvcount, recvtype, &newrecvtype);
-        MPI_Type_commit(&newsendtype);
         MPI_Type_commit(&newrecvtype);
         rc = MPI_Allgather(sendbuf, 1, newsendtype, recvbuf, 1, newrecvtype, comm);
-        MPI_Type_free(&newsendtype);
+        if (newsendtype!=MPI_DATATYPE_NULL) MPI_Type_free(&newsendtype);
         MPI_Type_free(&newrecvtype);
     }
     return rc;
 }
 
+/*
+ * Synopsis
+ *
+ * int BigMPI_Alltoall_in_place(void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype, MPI_Comm comm)
+ *
+ *  Input/Output Parameter
+ *
+ *   recvbuf            as in MPI_Alltoall with MPI_IN_PLACE
+ *
+ *  Input Parameters
+ *
+ *   recvcount, recvtype, comm   as in MPI_Alltoall
+ *
+ * Notes
+ *
+ *   Every pair of processes swaps the block that each holds for the other, one
+ *   chunk of at most BIGMPI_PIPELINE_CHUNK bytes at a time, so that only that much
+ *   scratch space is needed instead of a copy of the whole buffer.  The pairs are
+ *   scheduled by the circle method, which splits the exchange into size-1 rounds
+ *   (size rounds if size is odd) in which every process has at most one partner.
+ *
+ */
+static int BigMPI_Alltoall_in_place(void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype, MPI_Comm comm)
+{
+    bigmpi_context_t * ctx = BigMPI_Get_context(comm);
+
+    int rank, size = ctx->size;
+    MPI_Comm_rank(comm, &rank);
+
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(recvtype, &lb, &extent);
+
+    MPI_Count chunk = (extent>0) ? BigMPI_Get_pipeline_chunk()/extent : recvcount;
+    if (chunk < 1)              chunk = 1;
+    if (chunk > bigmpi_int_max) chunk = bigmpi_int_max;
+    if (chunk > recvcount)      chunk = recvcount;
+    char * scratch = BigMPI_Get_scratch(ctx, (MPI_Aint)chunk*extent);
+
+    /* With an odd number of processes, whoever is paired with the phantom process n-1 sits out the round. */
+    int n = (size%2==0) ? size : size+1;
+
+    int rc = MPI_SUCCESS;
+    for (int round=0; round<n-1 && rc==MPI_SUCCESS; round++) {
+        int partner;
+        if (rank==n-1) {
+            partner = round;
+        } else if (rank==round) {
+            partner = n-1;
+        } else {
+            partner = (2*round-rank+(n-1)) % (n-1);
+        }
+        if (partner>=size) continue;
+
+        char * block = (char*)recvbuf + (MPI_Aint)partner*recvcount*extent;
+        for (MPI_Count offset=0; offset<recvcount && rc==MPI_SUCCESS; offset+=chunk) {
+            int c = (int)(recvcount-offset < chunk ? recvcount-offset : chunk);
+            memcpy(scratch, block+offset*extent, (size_t)c*extent);
+            rc = MPI_Sendrecv(scratch, c, recvtype, partner, 0 /* tag */,
+                              block+offset*extent, c, recvtype, partner, 0 /* tag */,
+                              ctx->dup, MPI_STATUS_IGNORE);
+        }
+    }
+    return rc;
+}
+
 int MPIX_Alltoall_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
                     void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype, MPI_Comm comm)
 {
@@ -83,6 +585,8 @@ int MPIX_Alltoall_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatyp
 
     if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
         rc = MPI_Alltoall(sendbuf, (int)sendcount, sendtype, recvbuf, (int)recvcount, recvtype, comm);
+    } else if (sendbuf==MPI_IN_PLACE) {
+        rc = BigMPI_Alltoall_in_place(recvbuf, recvcount, recvtype, comm);
     } else {
         MPI_Datatype newsendtype, newrecvtype;
         BigMPI_Type_contiguous(0,sendcount, sendtype, &newsendtype);
@@ -102,7 +606,11 @@ int MPIX_Ibcast_x(void *buf, MPI_Count count, MPI_Datatype datatype, int root, M
 {
     int rc = MPI_SUCCESS;
 
-    if (likely (count <= bigmpi_int_max )) {
+    if (BigMPI_Icollective_pipelines(BIGMPI_IBCAST, NULL, 0, MPI_DATATYPE_NULL,
+                                     buf, count, datatype, root, comm)) {
+        rc = BigMPI_Icollective_pipelined(BIGMPI_IBCAST, NULL, 0, MPI_DATATYPE_NULL,
+                                          buf, count, datatype, root, comm, request);
+    } else if (likely (count <= bigmpi_int_max )) {
         rc = MPI_Ibcast(buf, (int)count, datatype, root, comm, request);
     } else {
         MPI_Datatype newtype;
@@ -119,7 +627,11 @@ int MPIX_Igather_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatype
 {
     int rc = MPI_SUCCESS;
 
-    if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
+    if (BigMPI_Icollective_pipelines(BIGMPI_IGATHER, sendbuf, sendcount, sendtype,
+                                     recvbuf, recvcount, recvtype, root, comm)) {
+        rc = BigMPI_Icollective_pipelined(BIGMPI_IGATHER, sendbuf, sendcount, sendtype,
+                                          recvbuf, recvcount, recvtype, root, comm, request);
+    } else if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
         rc = MPI_Igather(sendbuf, (int)sendcount, sendtype, recvbuf, (int)recvcount, recvtype, root, comm, request);
     } else {
         MPI_Datatype newsendtype, newrecvtype;
@@ -139,7 +651,11 @@ int MPIX_Iscatter_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatyp
 {
     int rc = MPI_SUCCESS;
 
-    if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
+    if (BigMPI_Icollective_pipelines(BIGMPI_ISCATTER, sendbuf, sendcount, sendtype,
+                                     recvbuf, recvcount, recvtype, root, comm)) {
+        rc = BigMPI_Icollective_pipelined(BIGMPI_ISCATTER, sendbuf, sendcount, sendtype,
+                                          recvbuf, recvcount, recvtype, root, comm, request);
+    } else if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
         rc = MPI_Iscatter(sendbuf, (int)sendcount, sendtype, recvbuf, (int)recvcount, recvtype, root, comm, request);
     } else {
         MPI_Datatype newsendtype, newrecvtype;
@@ -159,7 +675,11 @@ int MPIX_Iallgather_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datat
 {
     int rc = MPI_SUCCESS;
 
-    if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
+    if (BigMPI_Icollective_pipelines(BIGMPI_IALLGATHER, sendbuf, sendcount, sendtype,
+                                     recvbuf, recvcount, recvtype, 0, comm)) {
+        rc = BigMPI_Icollective_pipelined(BIGMPI_IALLGATHER, sendbuf, sendcount, sendtype,
+                                          recvbuf, recvcount, recvtype, 0, comm, request);
+    } else if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
         rc = MPI_Iallgather(sendbuf, (int)sendcount, sendtype, recvbuf, (int)recvcount, recvtype, comm, request);
     } else {
         MPI_Datatype newsendtype, newrecvtype;
@@ -179,7 +699,11 @@ int MPIX_Ialltoall_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Dataty
 {
     int rc = MPI_SUCCESS;
 
-    if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
+    if (BigMPI_Icollective_pipelines(BIGMPI_IALLTOALL, sendbuf, sendcount, sendtype,
+                                     recvbuf, recvcount, recvtype, 0, comm)) {
+        rc = BigMPI_Icollective_pipelined(BIGMPI_IALLTOALL, sendbuf, sendcount, sendtype,
+                                          recvbuf, recvcount, recvtype, 0, comm, request);
+    } else if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
         rc = MPI_Ialltoall(sendbuf, (int)sendcount, sendtype, recvbuf, (int)recvcount, recvtype, comm, request);
     } else {
         MPI_Datatype newsendtype, newrecvtype;
@@ -194,4 +718,168 @@ int MPIX_Ialltoall_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Dataty
     return rc;
 }
 
+/*
+ * Synopsis
+ *
+ * int MPIX_Bcast_shared_x(const void *buffer, MPI_Count count, MPI_Datatype datatype,
+ *                         int root, MPI_Comm comm, void *baseptr, MPI_Win *win)
+ *
+ *  Input Parameters
+ *
+ *   buffer            data to broadcast (significant only at root)
+ *   count             number of elements in buffer
+ *   datatype          datatype of the elements (handle)
+ *   root, comm        as in MPI_Bcast
+ *
+ * Output Parameters
+ *
+ *   baseptr           address of the node-local copy of the data (void**)
+ *   win               shared-memory window that owns the copy
+ *
+ * Notes
+ *
+ *   Every node allocates exactly one copy of the data, which is filled by
+ *   a broadcast among one leader process per node.  All processes on a node
+ *   receive a pointer to the same copy, so the data must be treated as
+ *   read-only unless the caller synchronizes on win.  The copy stays valid
+ *   until the caller frees win with MPI_Win_free.
+ *
+ */
+int MPIX_Bcast_shared_x(BIGMPI_CONST void *buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm,
+                        void *baseptr, MPI_Win *win)
+{
+    int rc = MPI_SUCCESS;
+
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    /* The node and leader communicators are cached on comm. */
+    bigmpi_context_t * ctx = BigMPI_Get_context(comm);
+
+    int noderank;
+    MPI_Comm_rank(ctx->node, &noderank);
+
+    /* The leader of the root's node is the root of the inter-node broadcast. */
+    int root_is_local = (ctx->leader_of[root]==ctx->leader_of[rank]);
+
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(datatype, &lb, &extent);
+    MPI_Aint bytes = (MPI_Aint)count * extent;
+
+    /* Only the leader contributes memory to the window. */
+    void * segment = NULL;
+    MPI_Win_allocate_shared(noderank==0 ? bytes : 0, 1 /* disp_unit */, MPI_INFO_NULL, ctx->node, &segment, win);
+    if (noderank!=0) {
+        MPI_Aint size /* unused */;
+        int disp_unit /* unused */;
+        MPI_Win_shared_query(*win, 0, &size, &disp_unit, &segment);
+    }
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, *win);
+
+    if (rank==root && buffer!=segment) {
+        memcpy(segment, buffer, (size_t)bytes);
+    }
+
+    /* The root's stores must be visible to its leader before the leader sends. */
+    if (root_is_local) {
+        MPI_Win_sync(*win);
+        MPI_Barrier(ctx->node);
+        MPI_Win_sync(*win);
+    }
+
+    if (ctx->leaders!=MPI_COMM_NULL) {
+        rc = MPIX_Bcast_x(segment, count, datatype, ctx->leader_of[root], ctx->leaders);
+    }
+
+    /* Everyone on the node waits until the leader has filled the segment. */
+    MPI_Win_sync(*win);
+    MPI_Barrier(ctx->node);
+    MPI_Win_sync(*win);
+
+    MPI_Win_unlock_all(*win);
+
+    *(void **)baseptr = segment;
+
+    return rc;
+}
+
+#endif
+
+#ifdef BIGMPI_HAVE_PERSISTENT_COLLECTIVES
+
+/*
+ * Synopsis
+ *
+ * int MPIX_Bcast_init_x(void *buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm,
+ *                       MPI_Info info, MPI_Request *request)
+ *
+ *  Input Parameters
+ *
+ *   all                as in MPI_Bcast_init
+ *
+ * Output Parameters
+ *
+ *   request            persistent request (handle)
+ *
+ * Notes
+ *
+ *   The large-count datatypes are built and committed once, here, instead of
+ *   on every MPI_Start.  The same holds for the other persistent collectives.
+ *   Not every MPI keeps the datatypes of a persistent collective alive, so
+ *   BigMPI caches the most recently used ones (see type_contiguous_x.c).
+ *
+ */
+int MPIX_Bcast_init_x(void *buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm,
+                      MPI_Info info, MPI_Request *request)
+{
+    int rc = MPI_SUCCESS;
+
+    if (likely (count <= bigmpi_int_max )) {
+        rc = BIGMPI_PCOLL(Bcast_init)(buffer, (int)count, datatype, root, comm, info, request);
+    } else {
+        MPI_Datatype newtype = BigMPI_Type_contiguous_cached(count, datatype);
+        rc = BIGMPI_PCOLL(Bcast_init)(buffer, 1, newtype, root, comm, info, request);
+    }
+    return rc;
+}
+
+int MPIX_Allgather_init_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                          void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype, MPI_Comm comm,
+                          MPI_Info info, MPI_Request *request)
+{
+    int rc = MPI_SUCCESS;
+
+    if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
+        rc = BIGMPI_PCOLL(Allgather_init)(sendbuf, (int)sendcount, sendtype, recvbuf, (int)recvcount, recvtype,
+                                          comm, info, request);
+    } else {
+        MPI_Datatype newsendtype = (sendbuf!=MPI_IN_PLACE) ? BigMPI_Type_contiguous_cached(sendcount, sendtype)
+                                                           : MPI_DATATYPE_NULL;
+        MPI_Datatype newrecvtype = BigMPI_Type_contiguous_cached(recvcount, recvtype);
+        rc = BIGMPI_PCOLL(Allgather_init)(sendbuf, 1, newsendtype, recvbuf, 1, newrecvtype, comm, info, request);
+    }
+    return rc;
+}
+
+/* Unlike MPIX_Alltoall_x, this passes MPI_IN_PLACE on to MPI, because a persistent
+ * request cannot run BigMPI's chunked pairwise exchange. */
+int MPIX_Alltoall_init_x(BIGMPI_CONST void *sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                         void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype, MPI_Comm comm,
+                         MPI_Info info, MPI_Request *request)
+{
+    int rc = MPI_SUCCESS;
+
+    if (likely (sendcount <= bigmpi_int_max && recvcount <= bigmpi_int_max )) {
+        rc = BIGMPI_PCOLL(Alltoall_init)(sendbuf, (int)sendcount, sendtype, recvbuf, (int)recvcount, recvtype,
+                                         comm, info, request);
+    } else {
+        MPI_Datatype newsendtype = (sendbuf!=MPI_IN_PLACE) ? BigMPI_Type_contiguous_cached(sendcount, sendtype)
+                                                           : MPI_DATATYPE_NULL;
+        MPI_Datatype newrecvtype = BigMPI_Type_contiguous_cached(recvcount, recvtype);
+        rc = BIGMPI_PCOLL(Alltoall_init)(sendbuf, 1, newsendtype, recvbuf, 1, newrecvtype, comm, info, request);
+    }
+    return rc;
+}
+
 #endif
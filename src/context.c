@@ -0,0 +1,509 @@
+#include "bigmpi_impl.h"
+#include <pthread.h>
+
+/* BigMPI keeps communicators, graph topologies and buffers that it needs
+ * internally in a context that is attached to the user's communicator
+ * as an attribute.  The context is created the first time a collective
+ * asks for it, which is why BigMPI_Get_context is collective, and it is
+ * destroyed together with the user's communicator. */
+
+static pthread_once_t BigMPI_context_keyval_is_initialized = PTHREAD_ONCE_INIT;
+static int BigMPI_context_keyval = MPI_KEYVAL_INVALID;
+
+/* Large collectives may be striped over several duplicates of the user's
+ * communicator (BIGMPI_STRIPES, default 1, i.e. no striping), which lets MPI
+ * libraries that map every communicator to its own network context drive
+ * several of them at once.  Only messages of at least
+ * BIGMPI_STRIPE_THRESHOLD bytes are striped.  Both settings must be the
+ * same on all processes. */
+
+static pthread_once_t BigMPI_stripes_are_initialized = PTHREAD_ONCE_INIT;
+static int BigMPI_nstripes = 1;
+static MPI_Count BigMPI_stripe_threshold = 0;
+
+/* Default size (in bytes) from which on collectives are striped. */
+#define BIGMPI_DEFAULT_STRIPE_THRESHOLD (1<<24)
+
+static void BigMPI_Read_stripe_settings(void)
+{
+    char * env_var = getenv("BIGMPI_STRIPES");
+    BigMPI_nstripes = (env_var != NULL) ? atoi(env_var) : 1;
+    if (BigMPI_nstripes < 1) {
+        BigMPI_nstripes = 1;
+    }
+
+    env_var = getenv("BIGMPI_STRIPE_THRESHOLD");
+    BigMPI_stripe_threshold = (env_var != NULL) ? (MPI_Count)strtoll(env_var, NULL, 10) : 0;
+    if (BigMPI_stripe_threshold <= 0) {
+        BigMPI_stripe_threshold = BIGMPI_DEFAULT_STRIPE_THRESHOLD;
+    }
+}
+
+static int BigMPI_Context_delete(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state)
+{
+    bigmpi_context_t * ctx = attribute_val;
+
+    if (ctx->graph_root!=NULL) {
+        for (int i=0; i<ctx->size; i++) {
+            if (ctx->graph_root[i]!=MPI_COMM_NULL) {
+                MPI_Comm_free(&ctx->graph_root[i]);
+            }
+        }
+        free(ctx->graph_root);
+    }
+    if (ctx->graph_all!=MPI_COMM_NULL) {
+        MPI_Comm_free(&ctx->graph_all);
+    }
+    if (ctx->leaders!=MPI_COMM_NULL) {
+        MPI_Comm_free(&ctx->leaders);
+    }
+    MPI_Comm_free(&ctx->node);
+    MPI_Comm_free(&ctx->dup);
+    free(ctx->leader_of);
+    free(ctx->ring);
+    if (ctx->scratch!=NULL) {
+        MPI_Free_mem(ctx->scratch);
+    }
+    if (ctx->stripes!=NULL) {
+        for (int i=0; i<BigMPI_nstripes; i++) {
+            MPI_Comm_free(&ctx->stripes[i]);
+        }
+        free(ctx->stripes);
+    }
+    free(ctx);
+
+    return MPI_SUCCESS;
+}
+
+/* MPI_COMM_WORLD is never freed by the user, so its context has to be
+ * released explicitly while MPI is still usable.  BigMPI_Find_context
+ * creates the keyval without a context, so there may be none. */
+static void BigMPI_Context_finalize(void)
+{
+    bigmpi_context_t * ctx = NULL;
+    int flag;
+    MPI_Comm_get_attr(MPI_COMM_WORLD, BigMPI_context_keyval, &ctx, &flag);
+    if (flag) {
+        MPI_Comm_delete_attr(MPI_COMM_WORLD, BigMPI_context_keyval);
+    }
+    MPI_Comm_free_keyval(&BigMPI_context_keyval);
+}
+
+static void BigMPI_Context_create_keyval(void)
+{
+    MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, BigMPI_Context_delete, &BigMPI_context_keyval, NULL);
+    BigMPI_Atfinalize(BigMPI_Context_finalize);
+}
+
+/* Count vectors of nonblocking collectives (see BigMPI_Get_int_counts) are kept in
+ * a separate attribute, because creating a context is collective and nonblocking
+ * collectives must not synchronize. */
+
+typedef struct bigmpi_int_counts_s {
+    struct bigmpi_int_counts_s * next;
+    int                          counts[];
+} bigmpi_int_counts_t;
+
+static pthread_once_t BigMPI_counts_keyval_is_initialized = PTHREAD_ONCE_INIT;
+static int BigMPI_counts_keyval = MPI_KEYVAL_INVALID;
+
+static int BigMPI_Int_counts_delete(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state)
+{
+    bigmpi_int_counts_t * c = attribute_val;
+    while (c!=NULL) {
+        bigmpi_int_counts_t * next = c->next;
+        free(c);
+        c = next;
+    }
+    return MPI_SUCCESS;
+}
+
+static void BigMPI_Int_counts_finalize(void)
+{
+    bigmpi_int_counts_t * c = NULL;
+    int flag;
+    MPI_Comm_get_attr(MPI_COMM_WORLD, BigMPI_counts_keyval, &c, &flag);
+    if (flag) {
+        MPI_Comm_delete_attr(MPI_COMM_WORLD, BigMPI_counts_keyval);
+    }
+    MPI_Comm_free_keyval(&BigMPI_counts_keyval);
+}
+
+static void BigMPI_Int_counts_create_keyval(void)
+{
+    MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, BigMPI_Int_counts_delete, &BigMPI_counts_keyval, NULL);
+    BigMPI_Atfinalize(BigMPI_Int_counts_finalize);
+}
+
+static bigmpi_context_t * BigMPI_Context_create(MPI_Comm comm)
+{
+    bigmpi_context_t * ctx = malloc(sizeof(bigmpi_context_t)); assert(ctx!=NULL);
+
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &ctx->size);
+
+    MPI_Comm_dup(comm, &ctx->dup);
+
+    /* Processes that can share memory form a node, and the lowest rank of every node is its leader. */
+#if MPI_VERSION >= 3
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0 /* key */, MPI_INFO_NULL, &ctx->node);
+#else
+    /* Without MPI_Comm_split_type, processes that report the same processor name form a node. */
+    {
+        char name[MPI_MAX_PROCESSOR_NAME] = {0};
+        int len;
+        MPI_Get_processor_name(name, &len);
+        char * names = malloc((size_t)ctx->size*MPI_MAX_PROCESSOR_NAME); assert(names!=NULL);
+        MPI_Allgather(name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, names, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, comm);
+        int color = rank;
+        for (int i=0; i<rank; i++) {
+            if (strncmp(&names[(size_t)i*MPI_MAX_PROCESSOR_NAME], name, MPI_MAX_PROCESSOR_NAME)==0) {
+                color = i;
+                break;
+            }
+        }
+        free(names);
+        MPI_Comm_split(comm, color, 0 /* key */, &ctx->node);
+    }
+#endif
+    int noderank;
+    MPI_Comm_rank(ctx->node, &noderank);
+    MPI_Comm_split(comm, noderank==0 ? 0 : MPI_UNDEFINED, 0 /* key */, &ctx->leaders);
+
+    /* Everyone learns which leader is responsible for every rank. */
+    int myleader = -1;
+    if (ctx->leaders!=MPI_COMM_NULL) {
+        MPI_Comm_rank(ctx->leaders, &myleader);
+    }
+    MPI_Bcast(&myleader, 1, MPI_INT, 0 /* root */, ctx->node);
+    ctx->leader_of = malloc(ctx->size*sizeof(int)); assert(ctx->leader_of!=NULL);
+    MPI_Allgather(&myleader, 1, MPI_INT, ctx->leader_of, 1, MPI_INT, comm);
+
+    /* Ring and pipeline algorithms visit the processes in the order of ring, which
+     * lists the nodes in the order of their leaders and the ranks of every node in
+     * ascending order, so that a ring crosses every node boundary only once. */
+    {
+        int nnodes = 0;
+        for (int i=0; i<ctx->size; i++) {
+            if (ctx->leader_of[i] >= nnodes) nnodes = ctx->leader_of[i]+1;
+        }
+        int * first = calloc(nnodes+1, sizeof(int)); assert(first!=NULL);
+        for (int i=0; i<ctx->size; i++) {
+            first[ctx->leader_of[i]+1]++;
+        }
+        for (int n=0; n<nnodes; n++) {
+            first[n+1] += first[n];
+        }
+        ctx->ring = malloc(ctx->size*sizeof(int)); assert(ctx->ring!=NULL);
+        for (int i=0; i<ctx->size; i++) {
+            int pos = first[ctx->leader_of[i]]++;
+            ctx->ring[pos] = i;
+            if (i==rank) ctx->ring_pos = pos;
+        }
+        free(first);
+    }
+
+    ctx->graph_all    = MPI_COMM_NULL;
+    ctx->graph_root   = NULL;
+    ctx->scratch      = NULL;
+    ctx->scratch_size = 0;
+    ctx->stripes      = NULL;
+    ctx->tag          = 0;
+    ctx->wire         = MPIX_WIRE_FULL;
+
+    return ctx;
+}
+
+/*
+ * Synopsis
+ *
+ * bigmpi_context_t * BigMPI_Get_context(MPI_Comm comm)
+ *
+ *  Input Parameter
+ *
+ *   comm               intracommunicator passed to a BigMPI collective
+ *
+ * Output Parameters
+ *
+ *   ctx                BigMPI context of comm (owned by the communicator)
+ *
+ * Notes
+ *
+ *   This function is collective over comm the first time it is called
+ *   on comm and local afterwards.
+ *
+ */
+bigmpi_context_t * BigMPI_Get_context(MPI_Comm comm)
+{
+    pthread_once(&BigMPI_context_keyval_is_initialized, BigMPI_Context_create_keyval);
+
+    bigmpi_context_t * ctx = NULL;
+    int flag;
+    MPI_Comm_get_attr(comm, BigMPI_context_keyval, &ctx, &flag);
+    if (likely(flag)) {
+        return ctx;
+    }
+
+    int is_intercomm;
+    MPI_Comm_test_inter(comm, &is_intercomm);
+    if (is_intercomm)
+        BigMPI_Error("BigMPI does not support intercommunicators yet.\n");
+
+    ctx = BigMPI_Context_create(comm);
+    MPI_Comm_set_attr(comm, BigMPI_context_keyval, ctx);
+    return ctx;
+}
+
+/*
+ * Synopsis
+ *
+ * bigmpi_context_t * BigMPI_Find_context(MPI_Comm comm)
+ *
+ *  Input Parameter
+ *
+ *   comm               communicator
+ *
+ * Output Parameters
+ *
+ *   ctx                BigMPI context of comm or NULL if it has none yet
+ *
+ * Notes
+ *
+ *   Unlike BigMPI_Get_context, this is always local.  Contexts are created
+ *   collectively, so either all processes of comm find one or none does.
+ *
+ */
+bigmpi_context_t * BigMPI_Find_context(MPI_Comm comm)
+{
+    pthread_once(&BigMPI_context_keyval_is_initialized, BigMPI_Context_create_keyval);
+
+    bigmpi_context_t * ctx = NULL;
+    int flag;
+    MPI_Comm_get_attr(comm, BigMPI_context_keyval, &ctx, &flag);
+    return flag ? ctx : NULL;
+}
+
+/*
+ * Synopsis
+ *
+ * void * BigMPI_Get_scratch(bigmpi_context_t * ctx, MPI_Aint bytes)
+ *
+ *  Input Parameters
+ *
+ *   ctx                BigMPI context
+ *   bytes              required size of the scratch buffer
+ *
+ * Output Parameters
+ *
+ *   scratch            buffer of at least bytes bytes
+ *
+ * Notes
+ *
+ *   The buffer is reused by every blocking collective on the communicator,
+ *   so it must not be held across calls or used by nonblocking operations.
+ *
+ */
+void * BigMPI_Get_scratch(bigmpi_context_t * ctx, MPI_Aint bytes)
+{
+    if (ctx->scratch_size < bytes) {
+        if (ctx->scratch!=NULL) {
+            MPI_Free_mem(ctx->scratch);
+        }
+        MPI_Alloc_mem(bytes, MPI_INFO_NULL, &ctx->scratch);
+        assert(ctx->scratch!=NULL);
+        ctx->scratch_size = bytes;
+    }
+    return ctx->scratch;
+}
+
+/*
+ * Synopsis
+ *
+ * int BigMPI_Get_schedule_tag(bigmpi_context_t * ctx)
+ *
+ *  Input Parameters
+ *
+ *   ctx                BigMPI context
+ *
+ * Output Parameters
+ *
+ *   tag                tag for the messages of a nonblocking operation on ctx->dup
+ *
+ * Notes
+ *
+ *   Nonblocking operations that send point-to-point messages on ctx->dup
+ *   need a tag of their own, so that their messages cannot match those of
+ *   other operations in flight.  Every process starts collectives on a
+ *   communicator in the same order, so all of them get the same tag.
+ *   Tag 0 is left to the blocking collectives and MPI guarantees that
+ *   tags up to 32767 are valid.
+ *
+ */
+int BigMPI_Get_schedule_tag(bigmpi_context_t * ctx)
+{
+    ctx->tag = ctx->tag % 32767 + 1;
+    return ctx->tag;
+}
+
+/*
+ * Synopsis
+ *
+ * const int * BigMPI_Get_int_counts(MPI_Comm comm, const MPI_Count counts[])
+ *
+ *  Input Parameters
+ *
+ *   comm               intracommunicator passed to a nonblocking collective
+ *   counts             one count per process of comm, each of which fits into an int
+ *
+ * Output Parameters
+ *
+ *   icounts            the same counts as ints (owned by the communicator)
+ *
+ * Notes
+ *
+ *   Nonblocking collectives may read their count vectors until they complete,
+ *   which BigMPI does not notice if it cannot free the vector together with a
+ *   datatype of the operation (see BigMPI_Type_free_on_completion), e.g. with
+ *   a user-defined op that was not created by MPIX_Op_create_x.  The vectors
+ *   returned here live as long as the communicator, and equal vectors are
+ *   shared, so there is one per distinct vector used on the communicator.
+ *
+ *   This function is local.
+ *
+ */
+const int * BigMPI_Get_int_counts(MPI_Comm comm, const MPI_Count counts[])
+{
+    pthread_once(&BigMPI_counts_keyval_is_initialized, BigMPI_Int_counts_create_keyval);
+
+    int size;
+    MPI_Comm_size(comm, &size);
+
+    /* The attribute is an empty list head, so adding a vector does not replace it. */
+    bigmpi_int_counts_t * head = NULL;
+    int flag;
+    MPI_Comm_get_attr(comm, BigMPI_counts_keyval, &head, &flag);
+    if (!flag) {
+        head = malloc(sizeof(bigmpi_int_counts_t)); assert(head!=NULL);
+        head->next = NULL;
+        MPI_Comm_set_attr(comm, BigMPI_counts_keyval, head);
+    }
+
+    for (bigmpi_int_counts_t * c = head->next; c!=NULL; c = c->next) {
+        int equal = 1;
+        for (int i=0; i<size && equal; i++) {
+            equal = (c->counts[i]==counts[i]);
+        }
+        if (equal) {
+            return c->counts;
+        }
+    }
+
+    bigmpi_int_counts_t * c = malloc(sizeof(bigmpi_int_counts_t)+size*sizeof(int)); assert(c!=NULL);
+    for (int i=0; i<size; i++) {
+        c->counts[i] = (int)counts[i];
+    }
+    c->next = head->next;
+    head->next = c;
+    return c->counts;
+}
+
+#if MPI_VERSION >= 3
+
+/*
+ * Synopsis
+ *
+ * MPI_Comm BigMPI_Get_graph_comm(bigmpi_context_t * ctx, int root)
+ *
+ *  Input Parameters
+ *
+ *   ctx                BigMPI context
+ *   root               as in BigMPI_Create_graph_comm
+ *
+ * Output Parameters
+ *
+ *   graph_comm         cached distributed graph communicator
+ *
+ * Notes
+ *
+ *   Collective over the communicator the first time a given root is used.
+ *
+ */
+MPI_Comm BigMPI_Get_graph_comm(bigmpi_context_t * ctx, int root)
+{
+    if (root == -1) {
+        if (ctx->graph_all==MPI_COMM_NULL) {
+            BigMPI_Create_graph_comm(ctx->dup, -1, &ctx->graph_all);
+        }
+        return ctx->graph_all;
+    }
+
+    if (ctx->graph_root==NULL) {
+        ctx->graph_root = malloc(ctx->size*sizeof(MPI_Comm)); assert(ctx->graph_root!=NULL);
+        for (int i=0; i<ctx->size; i++) {
+            ctx->graph_root[i] = MPI_COMM_NULL;
+        }
+    }
+    if (ctx->graph_root[root]==MPI_COMM_NULL) {
+        BigMPI_Create_graph_comm(ctx->dup, root, &ctx->graph_root[root]);
+    }
+    return ctx->graph_root[root];
+}
+
+/*
+ * Synopsis
+ *
+ * int BigMPI_Get_stripes(MPI_Count count, MPI_Datatype datatype)
+ *
+ *  Input Parameters
+ *
+ *   count, datatype    size of the message of one process
+ *
+ * Output Parameters
+ *
+ *   nstripes           number of stripes to use (1 means not to stripe)
+ *
+ */
+int BigMPI_Get_stripes(MPI_Count count, MPI_Datatype datatype)
+{
+    pthread_once(&BigMPI_stripes_are_initialized, BigMPI_Read_stripe_settings);
+
+    if (likely(BigMPI_nstripes == 1)) {
+        return 1;
+    }
+
+    int typesize;
+    MPI_Type_size(datatype, &typesize);
+    return (count*typesize >= BigMPI_stripe_threshold) ? BigMPI_nstripes : 1;
+}
+
+/*
+ * Synopsis
+ *
+ * MPI_Comm * BigMPI_Get_stripe_comms(bigmpi_context_t * ctx)
+ *
+ *  Input Parameter
+ *
+ *   ctx                BigMPI context
+ *
+ * Output Parameters
+ *
+ *   stripes            BigMPI_Get_stripes() duplicates of the communicator
+ *
+ * Notes
+ *
+ *   Collective over the communicator the first time it is called.
+ *
+ */
+MPI_Comm * BigMPI_Get_stripe_comms(bigmpi_context_t * ctx)
+{
+    if (ctx->stripes==NULL) {
+        ctx->stripes = malloc(BigMPI_nstripes*sizeof(MPI_Comm)); assert(ctx->stripes!=NULL);
+        for (int i=0; i<BigMPI_nstripes; i++) {
+            MPI_Comm_dup(ctx->dup, &ctx->stripes[i]);
+        }
+    }
+    return ctx->stripes;
+}
+
+#endif
@@ -0,0 +1,444 @@
+#include "bigmpi_impl.h"
+#include <pthread.h>
+#include <sched.h>
+
+/* Nonblocking BigMPI operations that cannot be expressed as a single MPI
+ * request (e.g. because they are pipelined over many chunks or because
+ * they own temporary buffers) are represented by a generalized request.
+ *
+ * Somebody has to notice that the underlying MPI requests have completed
+ * and call MPI_Grequest_complete.  MPI does not provide a portable way to
+ * do that from inside MPI_Test or MPI_Wait, so BigMPI supports:
+ *
+ *  - THREAD: a BigMPI progress thread (BIGMPI_PROGRESS_THREAD=1 in the
+ *    environment and MPI_THREAD_MULTIPLE),
+ *  - POLL:   the MPIX_Grequest_start extension of MPICH and its derivatives,
+ *            where MPI_Test and MPI_Wait call back into BigMPI,
+ *  - NONE:   neither of the above.  Callers must check BigMPI_Async_progress
+ *            and use a single native nonblocking operation (or fail) then,
+ *            because completing a BigMPI request inside the call that starts
+ *            it would make a nonblocking collective synchronizing.
+ */
+
+#if defined(MPICH_NUMVERSION) && !defined(BIGMPI_NO_MPIX_GREQUEST)
+#define BIGMPI_HAVE_MPIX_GREQUEST 1
+#endif
+
+typedef enum { PROGRESS_NONE,
+               PROGRESS_THREAD,
+               PROGRESS_POLL } bigmpi_progress_t;
+
+static pthread_once_t BigMPI_progress_is_initialized = PTHREAD_ONCE_INIT;
+static bigmpi_progress_t BigMPI_progress_method = PROGRESS_NONE;
+static MPI_Aint BigMPI_pipeline_chunk = 0;
+static int BigMPI_pipeline_depth = 0;
+
+/* Default size of one chunk of a pipelined operation, in bytes. */
+#define BIGMPI_DEFAULT_PIPELINE_CHUNK (1<<26)
+
+/* Default number of chunks that a pipelined blocking operation has in flight. */
+#define BIGMPI_DEFAULT_PIPELINE_DEPTH 4
+
+static void BigMPI_Detect_progress_method(void)
+{
+    char * env_var = getenv("BIGMPI_PIPELINE_CHUNK");
+    BigMPI_pipeline_chunk = (env_var != NULL) ? (MPI_Aint)strtoll(env_var, NULL, 10) : 0;
+    if (BigMPI_pipeline_chunk <= 0) {
+        BigMPI_pipeline_chunk = BIGMPI_DEFAULT_PIPELINE_CHUNK;
+    }
+
+    env_var = getenv("BIGMPI_PIPELINE_DEPTH");
+    BigMPI_pipeline_depth = (env_var != NULL) ? atoi(env_var) : 0;
+    if (BigMPI_pipeline_depth <= 0) {
+        BigMPI_pipeline_depth = BIGMPI_DEFAULT_PIPELINE_DEPTH;
+    }
+
+    env_var = getenv("BIGMPI_PROGRESS_THREAD");
+    if (env_var != NULL && atoi(env_var) > 0) {
+        int provided;
+        MPI_Query_thread(&provided);
+        if (provided == MPI_THREAD_MULTIPLE) {
+            BigMPI_progress_method = PROGRESS_THREAD;
+            return;
+        }
+        fprintf(stderr, "BIGMPI_PROGRESS_THREAD requires MPI_THREAD_MULTIPLE and will be ignored\n");
+    }
+
+#ifdef BIGMPI_HAVE_MPIX_GREQUEST
+    BigMPI_progress_method = PROGRESS_POLL;
+#else
+    BigMPI_progress_method = PROGRESS_NONE;
+#endif
+}
+
+/* Returns non-zero if BigMPI requests make progress without blocking the caller. */
+int BigMPI_Async_progress(void)
+{
+    pthread_once(&BigMPI_progress_is_initialized, BigMPI_Detect_progress_method);
+    return (BigMPI_progress_method != PROGRESS_NONE);
+}
+
+/* Returns the size (in bytes) of one chunk of a pipelined operation. */
+MPI_Aint BigMPI_Get_pipeline_chunk(void)
+{
+    pthread_once(&BigMPI_progress_is_initialized, BigMPI_Detect_progress_method);
+    return BigMPI_pipeline_chunk;
+}
+
+/* Returns the number of chunks that a pipelined blocking operation has in flight. */
+int BigMPI_Get_pipeline_depth(void)
+{
+    pthread_once(&BigMPI_progress_is_initialized, BigMPI_Detect_progress_method);
+    return BigMPI_pipeline_depth;
+}
+
+/*
+ * Synopsis
+ *
+ * bigmpi_request_t * BigMPI_Request_create(int nreqs)
+ *
+ *  Input Parameter
+ *
+ *   nreqs              number of MPI requests the operation has in flight at most
+ *
+ * Output Parameters
+ *
+ *   req                request with nreqs null requests and no progress function
+ *
+ */
+bigmpi_request_t * BigMPI_Request_create(int nreqs)
+{
+    bigmpi_request_t * req = malloc(sizeof(bigmpi_request_t)); assert(req!=NULL);
+
+    req->greq     = MPI_REQUEST_NULL;
+    req->nreqs    = nreqs;
+    req->reqs     = malloc(nreqs*sizeof(MPI_Request)); assert(nreqs==0 || req->reqs!=NULL);
+    for (int i=0; i<nreqs; i++) {
+        req->reqs[i] = MPI_REQUEST_NULL;
+    }
+    req->progress = NULL;
+    req->state    = NULL;
+    req->tempbuf  = NULL;
+    req->done     = 0;
+    req->next     = NULL;
+
+    return req;
+}
+
+/* Frees everything the operation owns.  The request itself lives until MPI frees the generalized request. */
+static void BigMPI_Request_release(bigmpi_request_t * req)
+{
+    free(req->reqs);
+    req->reqs  = NULL;
+    req->nreqs = 0;
+    free(req->state);
+    req->state = NULL;
+    if (req->tempbuf!=NULL) {
+        MPI_Free_mem(req->tempbuf);
+        req->tempbuf = NULL;
+    }
+}
+
+/* Returns non-zero (and releases the resources of req) once the operation is complete. */
+static int BigMPI_Request_poll(bigmpi_request_t * req)
+{
+    for (;;) {
+        int flag;
+        MPI_Testall(req->nreqs, req->reqs, &flag, MPI_STATUSES_IGNORE);
+        if (!flag) {
+            return 0;
+        }
+        /* The progress function either finishes the operation or posts the next requests. */
+        if (req->progress==NULL || req->progress(req)) {
+            break;
+        }
+    }
+    BigMPI_Request_release(req);
+    return 1;
+}
+
+static void BigMPI_Request_wait_local(bigmpi_request_t * req)
+{
+    for (;;) {
+        MPI_Waitall(req->nreqs, req->reqs, MPI_STATUSES_IGNORE);
+        if (req->progress==NULL || req->progress(req)) {
+            break;
+        }
+    }
+    BigMPI_Request_release(req);
+}
+
+static int BigMPI_Grequest_query(void *extra_state, MPI_Status *status)
+{
+    MPI_Status_set_elements(status, MPI_BYTE, 0);
+    MPI_Status_set_cancelled(status, 0);
+    status->MPI_SOURCE = MPI_UNDEFINED;
+    status->MPI_TAG    = MPI_UNDEFINED;
+    return MPI_SUCCESS;
+}
+
+static int BigMPI_Grequest_free(void *extra_state)
+{
+    free(extra_state);
+    return MPI_SUCCESS;
+}
+
+static int BigMPI_Grequest_cancel(void *extra_state, int complete)
+{
+    /* Collective operations cannot be cancelled. */
+    return MPI_SUCCESS;
+}
+
+#ifdef BIGMPI_HAVE_MPIX_GREQUEST
+
+static int BigMPI_Grequest_poll(void *extra_state, MPI_Status *status)
+{
+    bigmpi_request_t * req = extra_state;
+    if (!req->done && BigMPI_Request_poll(req)) {
+        req->done = 1;
+        MPI_Grequest_complete(req->greq);
+    }
+    return MPI_SUCCESS;
+}
+
+static int BigMPI_Grequest_wait(int count, void **array_of_states, double timeout, MPI_Status *status)
+{
+    for (int i=0; i<count; i++) {
+        bigmpi_request_t * req = array_of_states[i];
+        if (!req->done) {
+            BigMPI_Request_wait_local(req);
+            req->done = 1;
+            MPI_Grequest_complete(req->greq);
+        }
+    }
+    return MPI_SUCCESS;
+}
+
+#endif
+
+/* The progress thread polls every active request until the list is empty
+ * and sleeps on a condition variable otherwise. */
+
+static pthread_mutex_t    BigMPI_progress_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t     BigMPI_progress_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t          BigMPI_progress_thread;
+static int                BigMPI_progress_thread_running = 0;
+static int                BigMPI_progress_thread_shutdown = 0;
+static bigmpi_request_t * BigMPI_progress_list = NULL;
+
+static void * BigMPI_Progress_thread_fn(void * arg)
+{
+    pthread_mutex_lock(&BigMPI_progress_lock);
+    while (!BigMPI_progress_thread_shutdown) {
+        if (BigMPI_progress_list==NULL) {
+            pthread_cond_wait(&BigMPI_progress_cond, &BigMPI_progress_lock);
+            continue;
+        }
+        bigmpi_request_t ** prev = &BigMPI_progress_list;
+        while (*prev!=NULL) {
+            bigmpi_request_t * req = *prev;
+            if (BigMPI_Request_poll(req)) {
+                /* req may be freed by MPI as soon as it is complete, so unlink it first. */
+                *prev = req->next;
+                req->done = 1;
+                MPI_Grequest_complete(req->greq);
+            } else {
+                prev = &req->next;
+            }
+        }
+        pthread_mutex_unlock(&BigMPI_progress_lock);
+        sched_yield();
+        pthread_mutex_lock(&BigMPI_progress_lock);
+    }
+    pthread_mutex_unlock(&BigMPI_progress_lock);
+    return NULL;
+}
+
+static void BigMPI_Progress_thread_finalize(void)
+{
+    pthread_mutex_lock(&BigMPI_progress_lock);
+    BigMPI_progress_thread_shutdown = 1;
+    pthread_cond_signal(&BigMPI_progress_cond);
+    pthread_mutex_unlock(&BigMPI_progress_lock);
+
+    pthread_join(BigMPI_progress_thread, NULL);
+}
+
+/*
+ * Synopsis
+ *
+ * int BigMPI_Request_start(bigmpi_request_t * req, MPI_Request * request)
+ *
+ *  Input Parameter
+ *
+ *   req                operation whose first requests have been posted
+ *
+ * Output Parameters
+ *
+ *   request            generalized request that completes with the operation
+ *
+ * Notes
+ *
+ *   BigMPI owns req afterwards and frees it when the user frees request.
+ *
+ *   Only valid if BigMPI_Async_progress() is true.
+ *
+ */
+int BigMPI_Request_start(bigmpi_request_t * req, MPI_Request * request)
+{
+    pthread_once(&BigMPI_progress_is_initialized, BigMPI_Detect_progress_method);
+
+    int rc = MPI_SUCCESS;
+
+    switch (BigMPI_progress_method) {
+        case PROGRESS_THREAD:
+            rc = MPI_Grequest_start(BigMPI_Grequest_query, BigMPI_Grequest_free, BigMPI_Grequest_cancel,
+                                    req, &req->greq);
+            *request = req->greq;
+            pthread_mutex_lock(&BigMPI_progress_lock);
+            if (!BigMPI_progress_thread_running) {
+                pthread_create(&BigMPI_progress_thread, NULL, BigMPI_Progress_thread_fn, NULL);
+                BigMPI_progress_thread_running = 1;
+                BigMPI_Atfinalize(BigMPI_Progress_thread_finalize);
+            }
+            req->next = BigMPI_progress_list;
+            BigMPI_progress_list = req;
+            pthread_cond_signal(&BigMPI_progress_cond);
+            pthread_mutex_unlock(&BigMPI_progress_lock);
+            break;
+#ifdef BIGMPI_HAVE_MPIX_GREQUEST
+        case PROGRESS_POLL:
+            rc = MPIX_Grequest_start(BigMPI_Grequest_query, BigMPI_Grequest_free, BigMPI_Grequest_cancel,
+                                     BigMPI_Grequest_poll, BigMPI_Grequest_wait, req, &req->greq);
+            *request = req->greq;
+            break;
+#endif
+        default:
+            BigMPI_Error("BigMPI cannot start a request without asynchronous progress.  Check BigMPI_Async_progress first. \n");
+            break;
+    }
+    return rc;
+}
+
+/*
+ * Synopsis
+ *
+ * void BigMPI_Request_wait(bigmpi_request_t * req)
+ *
+ *  Input Parameter
+ *
+ *   req                operation whose first requests have been posted
+ *
+ * Notes
+ *
+ *   Completes and frees an operation that a blocking function has built
+ *   instead of handing it to the user with BigMPI_Request_start.
+ *
+ */
+void BigMPI_Request_wait(bigmpi_request_t * req)
+{
+    BigMPI_Request_wait_local(req);
+    free(req);
+}
+
+/* Without asynchronous progress, BigMPI can still learn that a single native
+ * nonblocking operation has completed, through a datatype that only this
+ * operation uses.  MPI keeps the datatypes of an operation alive until it
+ * completes, even if they are freed right after starting it, and Open MPI and
+ * MPICH delete the attributes of a datatype when its last reference goes away,
+ * i.e. inside the MPI_Test or MPI_Wait that completes the operation.  Where
+ * the attributes are deleted by MPI_Type_free instead, the operation is
+ * completed right there, so whatever BigMPI frees is never in use. */
+
+typedef struct {
+    bigmpi_completion_fn_t * fn;
+    void                   * state;
+    int                      freeing;   /* BigMPI_Type_free_on_completion is in MPI_Type_free */
+    int                      deleted;   /* the attribute was deleted while freeing was set */
+} bigmpi_completion_t;
+
+static pthread_once_t  BigMPI_completion_keyval_is_initialized = PTHREAD_ONCE_INIT;
+static pthread_mutex_t BigMPI_completion_lock = PTHREAD_MUTEX_INITIALIZER;
+static int             BigMPI_completion_keyval = MPI_KEYVAL_INVALID;
+
+static int BigMPI_Completion_delete(MPI_Datatype type, int keyval, void *attribute_val, void *extra_state)
+{
+    bigmpi_completion_t * c = attribute_val;
+
+    pthread_mutex_lock(&BigMPI_completion_lock);
+    int freeing = c->freeing;
+    c->deleted = freeing;
+    pthread_mutex_unlock(&BigMPI_completion_lock);
+
+    if (!freeing) {
+        c->fn(c->state);
+        free(c);
+    }
+    return MPI_SUCCESS;
+}
+
+static void BigMPI_Completion_finalize(void)
+{
+    MPI_Type_free_keyval(&BigMPI_completion_keyval);
+}
+
+static void BigMPI_Completion_create_keyval(void)
+{
+    MPI_Type_create_keyval(MPI_TYPE_NULL_COPY_FN, BigMPI_Completion_delete, &BigMPI_completion_keyval, NULL);
+    BigMPI_Atfinalize(BigMPI_Completion_finalize);
+}
+
+/*
+ * Synopsis
+ *
+ * int BigMPI_Type_free_on_completion(MPI_Datatype * type, MPI_Request * request,
+ *                                    bigmpi_completion_fn_t * fn, void * state)
+ *
+ *  Input Parameters
+ *
+ *   type               datatype that only the operation of request uses
+ *   request            native nonblocking operation that has just been started
+ *   fn                 called with state once the operation has completed
+ *   state              anything that fn needs, e.g. buffers to copy and free
+ *
+ * Output Parameters
+ *
+ *   type               MPI_DATATYPE_NULL
+ *   request            request of the operation, or MPI_REQUEST_NULL if it
+ *                      had to be completed (see above)
+ *
+ * Notes
+ *
+ *   fn runs inside an MPI call, so it must not call MPI itself.
+ *
+ */
+int BigMPI_Type_free_on_completion(MPI_Datatype * type, MPI_Request * request,
+                                   bigmpi_completion_fn_t * fn, void * state)
+{
+    pthread_once(&BigMPI_completion_keyval_is_initialized, BigMPI_Completion_create_keyval);
+
+    bigmpi_completion_t * c = malloc(sizeof(bigmpi_completion_t)); assert(c!=NULL);
+    c->fn      = fn;
+    c->state   = state;
+    c->freeing = 1;
+    c->deleted = 0;
+
+    MPI_Type_set_attr(*type, BigMPI_completion_keyval, c);
+    int rc = MPI_Type_free(type);
+
+    pthread_mutex_lock(&BigMPI_completion_lock);
+    c->freeing = 0;
+    int deleted = c->deleted;
+    pthread_mutex_unlock(&BigMPI_completion_lock);
+
+    if (deleted) {
+        int flag;
+        MPI_Request_get_status(*request, &flag, MPI_STATUS_IGNORE);
+        if (!flag) {
+            rc = MPI_Wait(request, MPI_STATUS_IGNORE);
+        }
+        fn(state);
+        free(c);
+    }
+    return rc;
+}
@@ -0,0 +1,490 @@
+#include "bigmpi_impl.h"
+#include <stdint.h>
+#include <pthread.h>
+
+/* MPI_Reduce_local is a switch-per-element loop in some MPI libraries and
+ * BigMPI calls it on billions of elements inside of its large-count ops,
+ * so BigMPI has its own kernels for the built-in ops on the built-in C types.
+ *
+ * The kernels are plain loops that the compiler vectorizes.  With GCC on
+ * x86-64 Linux, every kernel is compiled for AVX-512, AVX2 and the baseline
+ * ISA and the dynamic loader picks the best one for the CPU (target_clones).
+ * None of them may contract a*b+c into a fused multiply-add (which only some
+ * of the ISAs have), so that results do not depend on the CPU or on how a
+ * vector is split into pieces.  The build compiles this file with
+ * -ffp-contract=off for that (and with -ftree-vectorize), because the
+ * optimize attribute does not reliably turn contraction off in every clone.
+ * Everything else (e.g. long double, MPI_LONG_DOUBLE_INT or Fortran types)
+ * goes to MPI_Reduce_local. */
+
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 6) && defined(__x86_64__) && defined(__linux__)
+#define BIGMPI_KERNEL_ATTRIBUTES __attribute__((target_clones("avx512f","avx2","default")))
+#elif defined(__GNUC__) && !defined(__clang__)
+#define BIGMPI_KERNEL_ATTRIBUTES
+#else
+#pragma STDC FP_CONTRACT OFF
+#define BIGMPI_KERNEL_ATTRIBUTES
+#endif
+
+#ifndef BIGMPI_NO_REDUCE_KERNELS
+
+/* inoutvec[i] = invec[i] op inoutvec[i] for n elements */
+typedef void bigmpi_kernel_t(const void * restrict invec, void * restrict inoutvec, size_t n);
+
+#define BIGMPI_KERNEL(NAME, T, EXPR)                                            \
+static BIGMPI_KERNEL_ATTRIBUTES                                                 \
+void NAME(const void * restrict invec, void * restrict inoutvec, size_t n)      \
+{                                                                               \
+    const T * restrict a = invec;                                               \
+    T * restrict b = inoutvec;                                                  \
+    for (size_t i=0; i<n; i++) {                                                \
+        b[i] = (T)(EXPR);                                                       \
+    }                                                                           \
+}
+
+#define BIGMPI_ARITHMETIC_KERNELS(S, T)                                         \
+BIGMPI_KERNEL(BigMPI_max_##S,  T, a[i]>b[i] ? a[i] : b[i])                      \
+BIGMPI_KERNEL(BigMPI_min_##S,  T, a[i]<b[i] ? a[i] : b[i])                      \
+BIGMPI_KERNEL(BigMPI_sum_##S,  T, a[i]+b[i])                                    \
+BIGMPI_KERNEL(BigMPI_prod_##S, T, a[i]*b[i])
+
+#define BIGMPI_INTEGER_KERNELS(S, T)                                            \
+BIGMPI_ARITHMETIC_KERNELS(S, T)                                                 \
+BIGMPI_KERNEL(BigMPI_land_##S, T, a[i] && b[i])                                 \
+BIGMPI_KERNEL(BigMPI_band_##S, T, a[i] & b[i])                                  \
+BIGMPI_KERNEL(BigMPI_lor_##S,  T, a[i] || b[i])                                 \
+BIGMPI_KERNEL(BigMPI_bor_##S,  T, a[i] | b[i])                                  \
+BIGMPI_KERNEL(BigMPI_lxor_##S, T, !a[i] != !b[i])                               \
+BIGMPI_KERNEL(BigMPI_bxor_##S, T, a[i] ^ b[i])
+
+/* Complex numbers are pairs of reals (C99 6.2.5), so the sum is a sum of
+ * twice as many reals.  The product is written out because the one of C99
+ * Annex G handles infinities and NaNs in a way that does not vectorize.
+ * The real part adds the negated product instead of subtracting it, which
+ * is the same in IEEE arithmetic, because GCC 12 turns the textbook form
+ * into fused multiply-add-subtracts even with -ffp-contract=off. */
+#define BIGMPI_COMPLEX_KERNELS(S, R)                                            \
+static void BigMPI_sum_##S(const void * restrict invec, void * restrict inoutvec, size_t n) \
+{                                                                               \
+    BigMPI_sum_##R(invec, inoutvec, 2*n);                                       \
+}                                                                               \
+static BIGMPI_KERNEL_ATTRIBUTES                                                 \
+void BigMPI_prod_##S(const void * restrict invec, void * restrict inoutvec, size_t n) \
+{                                                                               \
+    const float_##R##_t * restrict a = invec;                                   \
+    float_##R##_t * restrict b = inoutvec;                                      \
+    for (size_t i=0; i<n; i++) {                                                \
+        float_##R##_t re = a[2*i]*b[2*i]   + (-a[2*i+1])*b[2*i+1];              \
+        float_##R##_t im = a[2*i]*b[2*i+1] + a[2*i+1]*b[2*i];                   \
+        b[2*i]   = re;                                                          \
+        b[2*i+1] = im;                                                          \
+    }                                                                           \
+}
+
+/* MAXLOC and MINLOC on the pair types (MPI-3 Section 5.9.4), where ties go
+ * to the smaller index.  MPI libraries tend to treat these as structs of
+ * unknown layout, but they are plain C structs.  The selects compile to
+ * conditional moves or blends rather than branches. */
+#define BIGMPI_PAIR_KERNELS(S, T)                                               \
+typedef struct { T v; int i; } bigmpi_pair_##S##_t;                             \
+static BIGMPI_KERNEL_ATTRIBUTES                                                 \
+void BigMPI_maxloc_##S(const void * restrict invec, void * restrict inoutvec, size_t n) \
+{                                                                               \
+    const bigmpi_pair_##S##_t * restrict a = invec;                             \
+    bigmpi_pair_##S##_t * restrict b = inoutvec;                                \
+    for (size_t i=0; i<n; i++) {                                                \
+        T   av = a[i].v, bv = b[i].v;                                           \
+        int ai = a[i].i, bi = b[i].i;                                           \
+        int mi = ai<bi ? ai : bi;                                               \
+        b[i].i = av>bv ? ai : (av<bv ? bi : mi);                                \
+        b[i].v = av>bv ? av : bv;                                               \
+    }                                                                           \
+}                                                                               \
+static BIGMPI_KERNEL_ATTRIBUTES                                                 \
+void BigMPI_minloc_##S(const void * restrict invec, void * restrict inoutvec, size_t n) \
+{                                                                               \
+    const bigmpi_pair_##S##_t * restrict a = invec;                             \
+    bigmpi_pair_##S##_t * restrict b = inoutvec;                                \
+    for (size_t i=0; i<n; i++) {                                                \
+        T   av = a[i].v, bv = b[i].v;                                           \
+        int ai = a[i].i, bi = b[i].i;                                           \
+        int mi = ai<bi ? ai : bi;                                               \
+        b[i].i = av<bv ? ai : (av>bv ? bi : mi);                                \
+        b[i].v = av<bv ? av : bv;                                               \
+    }                                                                           \
+}
+
+typedef float  float_f32_t;
+typedef double float_f64_t;
+
+BIGMPI_INTEGER_KERNELS(i8,  int8_t)
+BIGMPI_INTEGER_KERNELS(i16, int16_t)
+BIGMPI_INTEGER_KERNELS(i32, int32_t)
+BIGMPI_INTEGER_KERNELS(i64, int64_t)
+BIGMPI_INTEGER_KERNELS(u8,  uint8_t)
+BIGMPI_INTEGER_KERNELS(u16, uint16_t)
+BIGMPI_INTEGER_KERNELS(u32, uint32_t)
+BIGMPI_INTEGER_KERNELS(u64, uint64_t)
+BIGMPI_ARITHMETIC_KERNELS(f32, float)
+BIGMPI_ARITHMETIC_KERNELS(f64, double)
+BIGMPI_COMPLEX_KERNELS(c32, f32)
+BIGMPI_COMPLEX_KERNELS(c64, f64)
+BIGMPI_PAIR_KERNELS(float,  float)
+BIGMPI_PAIR_KERNELS(double, double)
+BIGMPI_PAIR_KERNELS(long,   long)
+BIGMPI_PAIR_KERNELS(2int,   int)
+BIGMPI_PAIR_KERNELS(short,  short)
+
+#undef BIGMPI_PAIR_KERNELS
+#undef BIGMPI_COMPLEX_KERNELS
+#undef BIGMPI_INTEGER_KERNELS
+#undef BIGMPI_ARITHMETIC_KERNELS
+#undef BIGMPI_KERNEL
+
+/* The rows of the kernel table.  MPI allows only the bitwise ops on MPI_BYTE
+ * and only the logical ops on MPI_C_BOOL, so those have rows of their own. */
+typedef enum { KERNEL_I8, KERNEL_I16, KERNEL_I32, KERNEL_I64,
+               KERNEL_U8, KERNEL_U16, KERNEL_U32, KERNEL_U64,
+               KERNEL_F32, KERNEL_F64, KERNEL_C32, KERNEL_C64,
+               KERNEL_BYTE, KERNEL_BOOL,
+               KERNEL_FLOAT_INT, KERNEL_DOUBLE_INT, KERNEL_LONG_INT, KERNEL_2INT, KERNEL_SHORT_INT,
+               KERNEL_NUM_TYPES, KERNEL_NO_TYPE = -1 } bigmpi_kernel_type_t;
+
+/* The columns, in the order of BigMPI_Op_create. */
+typedef enum { KERNEL_MAX, KERNEL_MIN, KERNEL_SUM, KERNEL_PROD,
+               KERNEL_LAND, KERNEL_BAND, KERNEL_LOR, KERNEL_BOR, KERNEL_LXOR, KERNEL_BXOR,
+               KERNEL_MAXLOC, KERNEL_MINLOC,
+               KERNEL_NUM_OPS, KERNEL_NO_OP = -1 } bigmpi_kernel_op_t;
+
+#define BIGMPI_INTEGER_ROW(S) { BigMPI_max_##S,  BigMPI_min_##S,  BigMPI_sum_##S,  BigMPI_prod_##S, \
+                                BigMPI_land_##S, BigMPI_band_##S, BigMPI_lor_##S,  BigMPI_bor_##S,  \
+                                BigMPI_lxor_##S, BigMPI_bxor_##S }
+
+#define BIGMPI_PAIR_ROW(S) { [KERNEL_MAXLOC] = BigMPI_maxloc_##S, [KERNEL_MINLOC] = BigMPI_minloc_##S }
+
+static bigmpi_kernel_t * const BigMPI_kernels[KERNEL_NUM_TYPES][KERNEL_NUM_OPS] = {
+    [KERNEL_I8]   = BIGMPI_INTEGER_ROW(i8),
+    [KERNEL_I16]  = BIGMPI_INTEGER_ROW(i16),
+    [KERNEL_I32]  = BIGMPI_INTEGER_ROW(i32),
+    [KERNEL_I64]  = BIGMPI_INTEGER_ROW(i64),
+    [KERNEL_U8]   = BIGMPI_INTEGER_ROW(u8),
+    [KERNEL_U16]  = BIGMPI_INTEGER_ROW(u16),
+    [KERNEL_U32]  = BIGMPI_INTEGER_ROW(u32),
+    [KERNEL_U64]  = BIGMPI_INTEGER_ROW(u64),
+    [KERNEL_F32]  = { BigMPI_max_f32, BigMPI_min_f32, BigMPI_sum_f32, BigMPI_prod_f32 },
+    [KERNEL_F64]  = { BigMPI_max_f64, BigMPI_min_f64, BigMPI_sum_f64, BigMPI_prod_f64 },
+    [KERNEL_C32]  = { [KERNEL_SUM] = BigMPI_sum_c32, [KERNEL_PROD] = BigMPI_prod_c32 },
+    [KERNEL_C64]  = { [KERNEL_SUM] = BigMPI_sum_c64, [KERNEL_PROD] = BigMPI_prod_c64 },
+    [KERNEL_BYTE] = { [KERNEL_BAND] = BigMPI_band_u8, [KERNEL_BOR]  = BigMPI_bor_u8,
+                      [KERNEL_BXOR] = BigMPI_bxor_u8 },
+    [KERNEL_BOOL] = { [KERNEL_LAND] = BigMPI_land_u8, [KERNEL_LOR]  = BigMPI_lor_u8,
+                      [KERNEL_LXOR] = BigMPI_lxor_u8 },
+    [KERNEL_FLOAT_INT]  = BIGMPI_PAIR_ROW(float),
+    [KERNEL_DOUBLE_INT] = BIGMPI_PAIR_ROW(double),
+    [KERNEL_LONG_INT]   = BIGMPI_PAIR_ROW(long),
+    [KERNEL_2INT]       = BIGMPI_PAIR_ROW(2int),
+    [KERNEL_SHORT_INT]  = BIGMPI_PAIR_ROW(short),
+};
+
+#undef BIGMPI_PAIR_ROW
+#undef BIGMPI_INTEGER_ROW
+
+static bigmpi_kernel_op_t BigMPI_Kernel_op(MPI_Op op)
+{
+    if      (op==MPI_MAX)    return KERNEL_MAX;
+    else if (op==MPI_MIN)    return KERNEL_MIN;
+    else if (op==MPI_SUM)    return KERNEL_SUM;
+    else if (op==MPI_PROD)   return KERNEL_PROD;
+    else if (op==MPI_LAND)   return KERNEL_LAND;
+    else if (op==MPI_BAND)   return KERNEL_BAND;
+    else if (op==MPI_LOR)    return KERNEL_LOR;
+    else if (op==MPI_BOR)    return KERNEL_BOR;
+    else if (op==MPI_LXOR)   return KERNEL_LXOR;
+    else if (op==MPI_BXOR)   return KERNEL_BXOR;
+    else if (op==MPI_MAXLOC) return KERNEL_MAXLOC;
+    else if (op==MPI_MINLOC) return KERNEL_MINLOC;
+    else                     return KERNEL_NO_OP;
+}
+
+#define BIGMPI_SIGNED_KERNEL(T)   (sizeof(T)==1 ? KERNEL_I8 : sizeof(T)==2 ? KERNEL_I16 : \
+                                   sizeof(T)==4 ? KERNEL_I32 : sizeof(T)==8 ? KERNEL_I64 : KERNEL_NO_TYPE)
+#define BIGMPI_UNSIGNED_KERNEL(T) (sizeof(T)==1 ? KERNEL_U8 : sizeof(T)==2 ? KERNEL_U16 : \
+                                   sizeof(T)==4 ? KERNEL_U32 : sizeof(T)==8 ? KERNEL_U64 : KERNEL_NO_TYPE)
+
+/* The pair kernels only apply if MPI lays out the pair type like the C compiler. */
+static bigmpi_kernel_type_t BigMPI_Kernel_pair(MPI_Datatype type, size_t size, bigmpi_kernel_type_t ktype)
+{
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    return (lb==0 && (size_t)extent==size) ? ktype : KERNEL_NO_TYPE;
+}
+
+static bigmpi_kernel_type_t BigMPI_Kernel_type(MPI_Datatype type)
+{
+    if      (type==MPI_DOUBLE)             return KERNEL_F64;
+    else if (type==MPI_FLOAT)              return KERNEL_F32;
+    else if (type==MPI_INT)                return BIGMPI_SIGNED_KERNEL(int);
+    else if (type==MPI_LONG)               return BIGMPI_SIGNED_KERNEL(long);
+    else if (type==MPI_LONG_LONG)          return BIGMPI_SIGNED_KERNEL(long long);
+    else if (type==MPI_LONG_LONG_INT)      return BIGMPI_SIGNED_KERNEL(long long);
+    else if (type==MPI_SHORT)              return BIGMPI_SIGNED_KERNEL(short);
+    else if (type==MPI_SIGNED_CHAR)        return BIGMPI_SIGNED_KERNEL(signed char);
+    else if (type==MPI_UNSIGNED)           return BIGMPI_UNSIGNED_KERNEL(unsigned);
+    else if (type==MPI_UNSIGNED_LONG)      return BIGMPI_UNSIGNED_KERNEL(unsigned long);
+    else if (type==MPI_UNSIGNED_LONG_LONG) return BIGMPI_UNSIGNED_KERNEL(unsigned long long);
+    else if (type==MPI_UNSIGNED_SHORT)     return BIGMPI_UNSIGNED_KERNEL(unsigned short);
+    else if (type==MPI_UNSIGNED_CHAR)      return BIGMPI_UNSIGNED_KERNEL(unsigned char);
+    else if (type==MPI_BYTE)               return KERNEL_BYTE;
+    else if (type==MPI_FLOAT_INT)          return BigMPI_Kernel_pair(type, sizeof(bigmpi_pair_float_t),  KERNEL_FLOAT_INT);
+    else if (type==MPI_DOUBLE_INT)         return BigMPI_Kernel_pair(type, sizeof(bigmpi_pair_double_t), KERNEL_DOUBLE_INT);
+    else if (type==MPI_LONG_INT)           return BigMPI_Kernel_pair(type, sizeof(bigmpi_pair_long_t),   KERNEL_LONG_INT);
+    else if (type==MPI_2INT)               return BigMPI_Kernel_pair(type, sizeof(bigmpi_pair_2int_t),   KERNEL_2INT);
+    else if (type==MPI_SHORT_INT)          return BigMPI_Kernel_pair(type, sizeof(bigmpi_pair_short_t),  KERNEL_SHORT_INT);
+#if MPI_VERSION >= 3 || (MPI_VERSION == 2 && MPI_SUBVERSION >= 2)
+    else if (type==MPI_INT8_T)             return KERNEL_I8;
+    else if (type==MPI_INT16_T)            return KERNEL_I16;
+    else if (type==MPI_INT32_T)            return KERNEL_I32;
+    else if (type==MPI_INT64_T)            return KERNEL_I64;
+    else if (type==MPI_UINT8_T)            return KERNEL_U8;
+    else if (type==MPI_UINT16_T)           return KERNEL_U16;
+    else if (type==MPI_UINT32_T)           return KERNEL_U32;
+    else if (type==MPI_UINT64_T)           return KERNEL_U64;
+    else if (type==MPI_AINT)               return BIGMPI_SIGNED_KERNEL(MPI_Aint);
+    else if (type==MPI_C_BOOL)             return (sizeof(_Bool)==1) ? KERNEL_BOOL : KERNEL_NO_TYPE;
+    else if (type==MPI_C_FLOAT_COMPLEX)    return KERNEL_C32;
+    else if (type==MPI_C_COMPLEX)          return KERNEL_C32;
+    else if (type==MPI_C_DOUBLE_COMPLEX)   return KERNEL_C64;
+#endif
+#if MPI_VERSION >= 3
+    else if (type==MPI_OFFSET)             return BIGMPI_SIGNED_KERNEL(MPI_Offset);
+    else if (type==MPI_COUNT)              return BIGMPI_SIGNED_KERNEL(MPI_Count);
+#endif
+    else                                   return KERNEL_NO_TYPE;
+}
+
+#undef BIGMPI_SIGNED_KERNEL
+#undef BIGMPI_UNSIGNED_KERNEL
+
+/* Large local reductions can be split over a pool of threads
+ * (BIGMPI_REDUCE_THREADS in the environment, counting the calling thread;
+ * 1 by default, i.e. no pool).  Every thread reduces one contiguous range
+ * of the buffers, so pages stay with the thread (and NUMA domain) that
+ * first touched them if the application initialized the buffers the same
+ * way, and walks through it in slices that fit into the cache.
+ * Only the kernels run on the pool, since MPI_Reduce_local would require
+ * MPI_THREAD_MULTIPLE. */
+
+/* Bytes of one slice and the minimum number of bytes per thread. */
+#define BIGMPI_REDUCE_SLICE      (1<<17)
+#define BIGMPI_REDUCE_THREAD_MIN (1<<20)
+
+typedef struct {
+    bigmpi_kernel_t * kernel;
+    const void      * in;
+    void            * inout;
+    size_t            count;
+    size_t            extent;
+    int               nthreads;
+} bigmpi_reduce_job_t;
+
+static pthread_once_t  BigMPI_reduce_threads_is_initialized = PTHREAD_ONCE_INIT;
+static int             BigMPI_reduce_nthreads = 1;
+
+static pthread_mutex_t BigMPI_pool_busy = PTHREAD_MUTEX_INITIALIZER;   /* one job at a time */
+static pthread_mutex_t BigMPI_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  BigMPI_pool_start = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  BigMPI_pool_done  = PTHREAD_COND_INITIALIZER;
+static pthread_t     * BigMPI_pool_threads = NULL;
+static int             BigMPI_pool_nworkers = 0;
+static int             BigMPI_pool_pending = 0;
+static int             BigMPI_pool_shutdown = 0;
+static unsigned        BigMPI_pool_generation = 0;
+static bigmpi_reduce_job_t BigMPI_pool_job;
+
+static void BigMPI_Read_reduce_threads(void)
+{
+    char * env_var = getenv("BIGMPI_REDUCE_THREADS");
+    BigMPI_reduce_nthreads = (env_var != NULL) ? atoi(env_var) : 1;
+    if (BigMPI_reduce_nthreads < 1) {
+        BigMPI_reduce_nthreads = 1;
+    }
+}
+
+/* Reduces the part of thread t of job. */
+static void BigMPI_Reduce_part(const bigmpi_reduce_job_t * job, int t)
+{
+    size_t q = job->count / job->nthreads;
+    size_t r = job->count % job->nthreads;
+    size_t first = t*q + ((size_t)t<r ? (size_t)t : r);
+    size_t last  = first + q + ((size_t)t<r ? 1 : 0);
+
+    size_t slice = BIGMPI_REDUCE_SLICE / job->extent;
+    if (slice==0) slice = 1;
+
+    for (size_t i=first; i<last; i+=slice) {
+        size_t n = (last-i < slice) ? last-i : slice;
+        job->kernel(job->in+i*job->extent, job->inout+i*job->extent, n);
+    }
+}
+
+static void * BigMPI_Reduce_worker_fn(void * arg)
+{
+    int t = (int)(intptr_t)arg;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&BigMPI_pool_lock);
+    for (;;) {
+        while (!BigMPI_pool_shutdown && BigMPI_pool_generation==seen) {
+            pthread_cond_wait(&BigMPI_pool_start, &BigMPI_pool_lock);
+        }
+        if (BigMPI_pool_shutdown) {
+            break;
+        }
+        seen = BigMPI_pool_generation;
+        bigmpi_reduce_job_t job = BigMPI_pool_job;
+        pthread_mutex_unlock(&BigMPI_pool_lock);
+
+        if (t < job.nthreads) {
+            BigMPI_Reduce_part(&job, t);
+        }
+
+        pthread_mutex_lock(&BigMPI_pool_lock);
+        if (--BigMPI_pool_pending==0) {
+            pthread_cond_signal(&BigMPI_pool_done);
+        }
+    }
+    pthread_mutex_unlock(&BigMPI_pool_lock);
+    return NULL;
+}
+
+static void BigMPI_Reduce_pool_finalize(void)
+{
+    pthread_mutex_lock(&BigMPI_pool_lock);
+    BigMPI_pool_shutdown = 1;
+    pthread_cond_broadcast(&BigMPI_pool_start);
+    pthread_mutex_unlock(&BigMPI_pool_lock);
+
+    for (int i=0; i<BigMPI_pool_nworkers; i++) {
+        pthread_join(BigMPI_pool_threads[i], NULL);
+    }
+    free(BigMPI_pool_threads);
+    BigMPI_pool_threads  = NULL;
+    BigMPI_pool_nworkers = 0;
+    BigMPI_pool_shutdown = 0;
+}
+
+/* Returns 1 if the pool has done the reduction and 0 if the caller has to do it. */
+static int BigMPI_Reduce_threaded(bigmpi_kernel_t * kernel, const void * in, void * inout,
+                                  size_t count, size_t extent)
+{
+    pthread_once(&BigMPI_reduce_threads_is_initialized, BigMPI_Read_reduce_threads);
+
+    size_t maxthreads = count*extent / BIGMPI_REDUCE_THREAD_MIN;
+    int nthreads = (maxthreads < (size_t)BigMPI_reduce_nthreads) ? (int)maxthreads : BigMPI_reduce_nthreads;
+    if (nthreads < 2) {
+        return 0;
+    }
+    /* Another thread is using the pool, so this one does not wait for it. */
+    if (pthread_mutex_trylock(&BigMPI_pool_busy)!=0) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&BigMPI_pool_lock);
+    if (BigMPI_pool_threads==NULL) {
+        BigMPI_pool_threads = malloc((BigMPI_reduce_nthreads-1)*sizeof(pthread_t));
+        assert(BigMPI_pool_threads!=NULL);
+        for (int i=0; i<BigMPI_reduce_nthreads-1; i++) {
+            pthread_create(&BigMPI_pool_threads[i], NULL, BigMPI_Reduce_worker_fn, (void*)(intptr_t)(i+1));
+        }
+        BigMPI_pool_nworkers = BigMPI_reduce_nthreads-1;
+        BigMPI_Atfinalize(BigMPI_Reduce_pool_finalize);
+    }
+    BigMPI_pool_job.kernel   = kernel;
+    BigMPI_pool_job.in       = in;
+    BigMPI_pool_job.inout    = inout;
+    BigMPI_pool_job.count    = count;
+    BigMPI_pool_job.extent   = extent;
+    BigMPI_pool_job.nthreads = nthreads;
+    BigMPI_pool_pending      = BigMPI_pool_nworkers;
+    BigMPI_pool_generation++;
+    pthread_cond_broadcast(&BigMPI_pool_start);
+    pthread_mutex_unlock(&BigMPI_pool_lock);
+
+    BigMPI_Reduce_part(&BigMPI_pool_job, 0);
+
+    pthread_mutex_lock(&BigMPI_pool_lock);
+    while (BigMPI_pool_pending > 0) {
+        pthread_cond_wait(&BigMPI_pool_done, &BigMPI_pool_lock);
+    }
+    pthread_mutex_unlock(&BigMPI_pool_lock);
+
+    pthread_mutex_unlock(&BigMPI_pool_busy);
+    return 1;
+}
+
+#endif /* BIGMPI_NO_REDUCE_KERNELS */
+
+/*
+ * Synopsis
+ *
+ * int MPIX_Reduce_local_x(const void *inbuf, void *inoutbuf, MPI_Count count,
+ *                         MPI_Datatype datatype, MPI_Op op)
+ *
+ *  Input Parameters
+ *
+ *   inbuf              input buffer
+ *   count              number of elements in each buffer
+ *   datatype           built-in datatype of the elements
+ *   op                 built-in operation
+ *
+ * Output Parameters
+ *
+ *   inoutbuf           inbuf[i] op inoutbuf[i] for every element i
+ *
+ * Notes
+ *
+ *   Uses the kernels of BigMPI if there is one for op and datatype and
+ *   MPI_Reduce_local on pieces of at most bigmpi_int_max elements otherwise.
+ *   Large kernel reductions run on BIGMPI_REDUCE_THREADS threads.
+ *
+ */
+int MPIX_Reduce_local_x(BIGMPI_CONST void *inbuf, void *inoutbuf, MPI_Count count,
+                        MPI_Datatype datatype, MPI_Op op)
+{
+#ifndef BIGMPI_NO_REDUCE_KERNELS
+    bigmpi_kernel_op_t   kop   = BigMPI_Kernel_op(op);
+    bigmpi_kernel_type_t ktype = BigMPI_Kernel_type(datatype);
+    if (kop!=KERNEL_NO_OP && ktype!=KERNEL_NO_TYPE && BigMPI_kernels[ktype][kop]!=NULL) {
+        bigmpi_kernel_t * kernel = BigMPI_kernels[ktype][kop];
+        /* The extent is not the size for the pair types of MAXLOC and MINLOC. */
+        MPI_Aint lb /* unused */, extent;
+        MPI_Type_get_extent(datatype, &lb, &extent);
+        if (!BigMPI_Reduce_threaded(kernel, inbuf, inoutbuf, (size_t)count, (size_t)extent)) {
+            kernel(inbuf, inoutbuf, (size_t)count);
+        }
+        return MPI_SUCCESS;
+    }
+#endif
+
+    if (likely (count <= bigmpi_int_max )) {
+        return MPI_Reduce_local(inbuf, inoutbuf, (int)count, datatype, op);
+    } else {
+        int c = (int)(count/bigmpi_int_max);
+        int r = (int)(count%bigmpi_int_max);
+
+        /* The extent is not the size for the pair types of MAXLOC and MINLOC. */
+        MPI_Aint lb /* unused */, extent;
+        MPI_Type_get_extent(datatype, &lb, &extent);
+
+        int rc = MPI_SUCCESS;
+        for (int i=0; i<c; i++) {
+            rc = MPI_Reduce_local(inbuf+(size_t)i*bigmpi_int_max*extent,
+                                  inoutbuf+(size_t)i*bigmpi_int_max*extent,
+                                  bigmpi_int_max, datatype, op);
+            if (rc!=MPI_SUCCESS) return rc;
+        }
+        return MPI_Reduce_local(inbuf+(size_t)c*bigmpi_int_max*extent,
+                                inoutbuf+(size_t)c*bigmpi_int_max*extent,
+                                r, datatype, op);
+    }
+}
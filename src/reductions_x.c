@@ -1,4 +1,6 @@
 #include "bigmpi_impl.h"
+#include <pthread.h>
+#include <stdint.h>
 
 /* There are different ways to implement large-count reductions.
  * The fully general and most correct way to do it is with user-defined
@@ -15,27 +17,17 @@
 #define PASTE_BIGMPI_REDUCE_OP(OP)                                                      \
 void BigMPI_##OP##_x(void * invec, void * inoutvec, int * len, MPI_Datatype * bigtype)  \
 {                                                                                       \
-    /* We are reducing a single element of bigtype... */                                \
-    assert(*len==1);                                                                    \
+    /* We are usually reducing a single element of bigtype, but reduce-scatters reduce  \
+     * one per process, and some MPI libraries (e.g. the libnbc component of Open MPI)  \
+     * segment a nonblocking reduction and call the op for empty segments, too.         \
+     * Elements of bigtype are contiguous, so all of them are a single vector. */       \
+    if (*len==0) return;                                                                \
                                                                                         \
     MPI_Count count;                                                                    \
     MPI_Datatype basetype;                                                              \
     BigMPI_Decode_contiguous_x(*bigtype, &count, &basetype);                            \
                                                                                         \
-    int c = (int)(count/bigmpi_int_max);                                                \
-    int r = (int)(count%bigmpi_int_max);                                                \
-                                                                                        \
-    /* Can use typesize rather than extent here because all built-ins lack holes. */    \
-    int typesize;                                                                       \
-    MPI_Type_size(basetype, &typesize);                                                 \
-    for (int i=0; i<c; i++) {                                                           \
-        MPI_Reduce_local(invec+(size_t)i*bigmpi_int_max*(size_t)typesize,               \
-                         inoutvec+i*bigmpi_int_max*(size_t)typesize,                    \
-                         bigmpi_int_max, basetype, MPI_##OP);                           \
-    }                                                                                   \
-    MPI_Reduce_local(invec+(size_t)c*bigmpi_int_max*(size_t)typesize,                   \
-                     inoutvec+c*bigmpi_int_max*(size_t)typesize,                        \
-                     r, basetype, MPI_##OP);                                            \
+    MPIX_Reduce_local_x(invec, inoutvec, count*(*len), basetype, MPI_##OP);             \
                                                                                         \
     return;                                                                             \
 }
@@ -76,234 +68,2014 @@ int BigMPI_Op_create(MPI_Op op, MPI_Op * bigop)
     else if (op==MPI_MAXLOC) bigfn = BigMPI_MAXLOC_x;
     else if (op==MPI_MINLOC) bigfn = BigMPI_MINLOC_x;
     else {
-        BigMPI_Error("BigMPI does not support this op.  Sorry. \n");
+        BigMPI_Error("BigMPI does not support this op.  Use MPIX_Op_create_x for user-defined ops. \n");
     }
     return MPI_Op_create(bigfn, commute, bigop);
 }
 
-int MPIX_Reduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
-                  MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm)
+/* Large-count reductions use the same big op for every call with the same
+ * built-in op, so the big ops are created once, on first use, and freed at
+ * MPI_Finalize.  Nonblocking and persistent reductions need this anyways,
+ * because their big op has to live as long as the request and we do not
+ * learn when the user frees the request.
+ *
+ * Anything else that BigMPI wants to remember about a built-in op belongs
+ * into bigmpi_op_entry_t, too. */
+
+#define BIGMPI_NUM_BUILTIN_OPS 12
+
+typedef struct {
+    MPI_Op op;      /* built-in op */
+    MPI_Op bigop;   /* reduces one element of a large-count type, see BigMPI_Op_create */
+} bigmpi_op_entry_t;
+
+static pthread_mutex_t   BigMPI_op_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static bigmpi_op_entry_t BigMPI_op_cache[BIGMPI_NUM_BUILTIN_OPS];
+static int               BigMPI_op_cache_count = 0;
+
+static void BigMPI_Op_cache_finalize(void)
 {
-    if (likely (count <= bigmpi_int_max )) {
-        return MPI_Reduce(sendbuf, recvbuf, (int)count, datatype, op, root, comm);
-    } else {
-#ifdef BIGMPI_CLEAVER
-        int c = (int)(count/bigmpi_int_max);
-        int r = (int)(count%bigmpi_int_max);
-        int typesize;
-        MPI_Type_size(datatype, &typesize);
-        if (sendbuf==MPI_IN_PLACE) {
-            int commrank;
-            MPI_Comm_rank(comm, &commrank);
-            for (ptrdiff_t i=0; i<c; i++) {
-                MPI_Reduce(commrank==root ? MPI_IN_PLACE : recvbuf+i*bigmpi_int_max*(size_t)typesize,
-                           recvbuf+i*bigmpi_int_max*(size_t)typesize,
-                           bigmpi_int_max, datatype, op, root, comm);
-            }
-            MPI_Reduce(commrank==root ? MPI_IN_PLACE : recvbuf+c*bigmpi_int_max*(size_t)typesize,
-                       recvbuf+c*bigmpi_int_max*(size_t)typesize,
-                       r, datatype, op, root, comm);
-        } else {
-            for (ptrdiff_t i=0; i<c; i++) {
-                MPI_Reduce(sendbuf+i*bigmpi_int_max*(size_t)typesize,
-                           recvbuf+i*bigmpi_int_max*(size_t)typesize,
-                           bigmpi_int_max, datatype, op, root, comm);
-            }
-            MPI_Reduce(sendbuf+c*bigmpi_int_max*(size_t)typesize,
-                       recvbuf+c*bigmpi_int_max*(size_t)typesize,
-                       r, datatype, op, root, comm);
-        }
-        return MPI_SUCCESS;
-#else /* BIGMPI_CLEAVER */
+    pthread_mutex_lock(&BigMPI_op_cache_lock);
+    for (int i=0; i<BigMPI_op_cache_count; i++) {
+        MPI_Op_free(&BigMPI_op_cache[i].bigop);
+    }
+    BigMPI_op_cache_count = 0;
+    pthread_mutex_unlock(&BigMPI_op_cache_lock);
+}
 
-        MPI_Datatype bigtype;
-        BigMPI_Type_contiguous(0,count, datatype, &bigtype);
-        MPI_Type_commit(&bigtype);
+/* Returns the cache entry of a built-in op, creating it if necessary. */
+static bigmpi_op_entry_t * BigMPI_Op_get_entry(MPI_Op op)
+{
+    bigmpi_op_entry_t * entry = NULL;
 
+    pthread_mutex_lock(&BigMPI_op_cache_lock);
+    for (int i=0; i<BigMPI_op_cache_count; i++) {
+        if (BigMPI_op_cache[i].op==op) {
+            entry = &BigMPI_op_cache[i];
+            break;
+        }
+    }
+    if (entry==NULL) {
+        /* BigMPI_Op_create fails for anything but the built-in ops, so the cache cannot overflow. */
         MPI_Op bigop;
         BigMPI_Op_create(op, &bigop);
+        if (BigMPI_op_cache_count==0) {
+            BigMPI_Atfinalize(BigMPI_Op_cache_finalize);
+        }
+        entry = &BigMPI_op_cache[BigMPI_op_cache_count++];
+        entry->op    = op;
+        entry->bigop = bigop;
+    }
+    pthread_mutex_unlock(&BigMPI_op_cache_lock);
 
-        /* This is overkill.  Only the root needs to copy the buffer. */
-        void * tempbuf = NULL;
-        if (sendbuf==MPI_IN_PLACE) {
-            MPI_Aint lb /* unused */, extent;
-            MPI_Type_get_extent(datatype, &lb, &extent);
-            MPI_Aint buf_size = (MPI_Aint)count * extent;
+    return entry;
+}
 
-            MPI_Alloc_mem(buf_size, MPI_INFO_NULL, &tempbuf);
-            assert(tempbuf!=NULL);
-            memcpy(tempbuf, recvbuf, (size_t)buf_size);
-        }
+/* User-defined ops that large-count reductions can use (see MPIX_Op_create_x).
+ * MPI does not pass any state to an op, so the big op of every slot has a
+ * callback of its own, which looks up the user function in the slot. */
 
-        int rc = MPI_Reduce(sendbuf==MPI_IN_PLACE ? tempbuf : sendbuf,
-                            recvbuf, 1, bigtype, bigop, root, comm);
+#define BIGMPI_MAX_USER_OPS 16
 
-        if (sendbuf==MPI_IN_PLACE) {
-            MPI_Free_mem(&tempbuf);
-        }
+typedef struct {
+    MPI_User_function * fn;     /* NULL if the slot is free */
+    MPI_Op              op;     /* handed to the user */
+    MPI_Op              bigop;  /* reduces one element of a large-count type */
+} bigmpi_user_op_t;
 
-        MPI_Type_free(&bigtype);
-        MPI_Op_free(&bigop);
+static bigmpi_user_op_t BigMPI_user_ops[BIGMPI_MAX_USER_OPS];
+static int              BigMPI_user_ops_registered = 0;
 
-        return rc;
+/* Calls the user function of slot on int-sized pieces of len elements of bigtype. */
+static void BigMPI_User_op_apply(int slot, void * invec, void * inoutvec, int * len, MPI_Datatype * bigtype)
+{
+    /* See PASTE_BIGMPI_REDUCE_OP. */
+    if (*len==0) return;
 
-#endif /* BIGMPI_CLEAVER */
+    MPI_Count count;
+    MPI_Datatype basetype;
+    BigMPI_Decode_contiguous_x(*bigtype, &count, &basetype);
+    count *= *len;
+
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(basetype, &lb, &extent);
+
+    MPI_User_function * fn = BigMPI_user_ops[slot].fn;
+    for (MPI_Count offset=0; offset<count; offset+=bigmpi_int_max) {
+        int n = (int)(count-offset < bigmpi_int_max ? count-offset : bigmpi_int_max);
+        fn(invec+offset*extent, inoutvec+offset*extent, &n, &basetype);
     }
 }
 
-int MPIX_Allreduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
-                     MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+#define PASTE_BIGMPI_USER_OP(SLOT)                                                                 \
+static void BigMPI_User_op_##SLOT(void * invec, void * inoutvec, int * len, MPI_Datatype * bigtype) \
+{                                                                                                   \
+    BigMPI_User_op_apply(SLOT, invec, inoutvec, len, bigtype);                                      \
+}
+
+PASTE_BIGMPI_USER_OP(0)
+PASTE_BIGMPI_USER_OP(1)
+PASTE_BIGMPI_USER_OP(2)
+PASTE_BIGMPI_USER_OP(3)
+PASTE_BIGMPI_USER_OP(4)
+PASTE_BIGMPI_USER_OP(5)
+PASTE_BIGMPI_USER_OP(6)
+PASTE_BIGMPI_USER_OP(7)
+PASTE_BIGMPI_USER_OP(8)
+PASTE_BIGMPI_USER_OP(9)
+PASTE_BIGMPI_USER_OP(10)
+PASTE_BIGMPI_USER_OP(11)
+PASTE_BIGMPI_USER_OP(12)
+PASTE_BIGMPI_USER_OP(13)
+PASTE_BIGMPI_USER_OP(14)
+PASTE_BIGMPI_USER_OP(15)
+
+#undef PASTE_BIGMPI_USER_OP
+
+static MPI_User_function * const BigMPI_user_op_fns[BIGMPI_MAX_USER_OPS] = {
+    BigMPI_User_op_0,  BigMPI_User_op_1,  BigMPI_User_op_2,  BigMPI_User_op_3,
+    BigMPI_User_op_4,  BigMPI_User_op_5,  BigMPI_User_op_6,  BigMPI_User_op_7,
+    BigMPI_User_op_8,  BigMPI_User_op_9,  BigMPI_User_op_10, BigMPI_User_op_11,
+    BigMPI_User_op_12, BigMPI_User_op_13, BigMPI_User_op_14, BigMPI_User_op_15
+};
+
+static void BigMPI_User_ops_finalize(void)
 {
-    if (likely (count <= bigmpi_int_max )) {
-        return MPI_Allreduce(sendbuf, recvbuf, (int)count, datatype, op, comm);
-    } else {
-#ifdef BIGMPI_CLEAVER
-        int c = (int)(count/bigmpi_int_max);
-        int r = (int)(count%bigmpi_int_max);
-        int typesize;
-        MPI_Type_size(datatype, &typesize);
-        if (sendbuf==MPI_IN_PLACE) {
-            for (ptrdiff_t i=0; i<c; i++) {
-                MPI_Allreduce(MPI_IN_PLACE, recvbuf+i*bigmpi_int_max*(size_t)typesize,
-                              bigmpi_int_max, datatype, op, comm);
-            }
-            MPI_Allreduce(MPI_IN_PLACE, recvbuf+c*bigmpi_int_max*(size_t)typesize,
-                          r, datatype, op, comm);
-        } else {
-            for (ptrdiff_t i=0; i<c; i++) {
-                MPI_Allreduce(sendbuf+i*bigmpi_int_max*(size_t)typesize,
-                              recvbuf+i*bigmpi_int_max*(size_t)typesize,
-                              bigmpi_int_max, datatype, op, comm);
-            }
-            MPI_Allreduce(sendbuf+c*bigmpi_int_max*(size_t)typesize,
-                          recvbuf+c*bigmpi_int_max*(size_t)typesize,
-                          r, datatype, op, comm);
+    pthread_mutex_lock(&BigMPI_op_cache_lock);
+    for (int i=0; i<BIGMPI_MAX_USER_OPS; i++) {
+        if (BigMPI_user_ops[i].fn!=NULL) {
+            MPI_Op_free(&BigMPI_user_ops[i].bigop);
+            BigMPI_user_ops[i].fn = NULL;
         }
-        return MPI_SUCCESS;
-#else /* BIGMPI_CLEAVER */
+    }
+    BigMPI_user_ops_registered = 0;
+    pthread_mutex_unlock(&BigMPI_op_cache_lock);
+}
 
-        MPI_Datatype bigtype;
-        BigMPI_Type_contiguous(0,count, datatype, &bigtype);
-        MPI_Type_commit(&bigtype);
+/*
+ * Synopsis
+ *
+ * int MPIX_Op_create_x(MPI_User_function *user_fn, int commute, MPI_Op *op)
+ *
+ *  Input Parameters
+ *
+ *   user_fn            user-defined function
+ *   commute            true if commutative; false otherwise
+ *
+ * Output Parameters
+ *
+ *   op                 operation
+ *
+ * Notes
+ *
+ *   Like MPI_Op_create, except that the op can be used in large-count
+ *   reductions, too.  These call user_fn on at most INT_MAX elements at
+ *   a time.  Such ops must be freed with MPIX_Op_free_x.  BigMPI supports
+ *   16 of them at a time.
+ *
+ */
+int MPIX_Op_create_x(MPI_User_function *user_fn, int commute, MPI_Op *op)
+{
+    pthread_mutex_lock(&BigMPI_op_cache_lock);
 
-        MPI_Op bigop;
-        BigMPI_Op_create(op, &bigop);
+    int slot = 0;
+    while (slot<BIGMPI_MAX_USER_OPS && BigMPI_user_ops[slot].fn!=NULL) {
+        slot++;
+    }
+    if (slot==BIGMPI_MAX_USER_OPS) {
+        pthread_mutex_unlock(&BigMPI_op_cache_lock);
+        BigMPI_Error("BigMPI does not support more than %d user-defined ops at a time.  Sorry. \n",
+                     BIGMPI_MAX_USER_OPS);
+    }
 
-        void * tempbuf = NULL;
-        if (sendbuf==MPI_IN_PLACE) {
-            MPI_Aint lb /* unused */, extent;
-            MPI_Type_get_extent(datatype, &lb, &extent);
-            MPI_Aint buf_size = (MPI_Aint)count * extent;
+    int rc = MPI_Op_create(user_fn, commute, op);
+    if (rc==MPI_SUCCESS) {
+        rc = MPI_Op_create(BigMPI_user_op_fns[slot], commute, &BigMPI_user_ops[slot].bigop);
+        if (rc!=MPI_SUCCESS) {
+            /* The slot is claimed only below, so it stays free; just drop the first op. */
+            MPI_Op_free(op);
+            BigMPI_user_ops[slot].bigop = MPI_OP_NULL;
+        }
+    }
+    if (rc==MPI_SUCCESS) {
+        BigMPI_user_ops[slot].fn = user_fn;
+        BigMPI_user_ops[slot].op = *op;
+        if (!BigMPI_user_ops_registered) {
+            BigMPI_Atfinalize(BigMPI_User_ops_finalize);
+            BigMPI_user_ops_registered = 1;
+        }
+    }
 
-            MPI_Alloc_mem(buf_size, MPI_INFO_NULL, &tempbuf);
-            assert(tempbuf!=NULL);
-            memcpy(tempbuf, recvbuf, (size_t)buf_size);
+    pthread_mutex_unlock(&BigMPI_op_cache_lock);
+    return rc;
+}
+
+/*
+ * Synopsis
+ *
+ * int MPIX_Op_free_x(MPI_Op *op)
+ *
+ *  Input/Output Parameters
+ *
+ *   op                 operation created by MPIX_Op_create_x
+ *
+ */
+int MPIX_Op_free_x(MPI_Op *op)
+{
+    pthread_mutex_lock(&BigMPI_op_cache_lock);
+    for (int i=0; i<BIGMPI_MAX_USER_OPS; i++) {
+        if (BigMPI_user_ops[i].fn!=NULL && BigMPI_user_ops[i].op==*op) {
+            MPI_Op_free(&BigMPI_user_ops[i].bigop);
+            BigMPI_user_ops[i].fn = NULL;
+            break;
         }
-        int rc = MPI_Allreduce(sendbuf==MPI_IN_PLACE ? tempbuf : sendbuf,
-                               recvbuf, 1, bigtype, bigop, comm);
-        if (sendbuf==MPI_IN_PLACE) {
-            MPI_Free_mem(&tempbuf);
+    }
+    pthread_mutex_unlock(&BigMPI_op_cache_lock);
+
+    return MPI_Op_free(op);
+}
+
+/* Returns the big op of a built-in op or of one created by MPIX_Op_create_x.  It must not be freed. */
+MPI_Op BigMPI_Op_get_cached(MPI_Op op)
+{
+    MPI_Op bigop = MPI_OP_NULL;
+
+    pthread_mutex_lock(&BigMPI_op_cache_lock);
+    for (int i=0; i<BIGMPI_MAX_USER_OPS; i++) {
+        if (BigMPI_user_ops[i].fn!=NULL && BigMPI_user_ops[i].op==op) {
+            bigop = BigMPI_user_ops[i].bigop;
+            break;
         }
+    }
+    pthread_mutex_unlock(&BigMPI_op_cache_lock);
 
-        MPI_Type_free(&bigtype);
-        MPI_Op_free(&bigop);
+    return (bigop!=MPI_OP_NULL) ? bigop : BigMPI_Op_get_entry(op)->bigop;
+}
 
-        return rc;
+/* Returns non-zero if op has a big op, i.e. if it is a built-in op or one created by MPIX_Op_create_x. */
+static int BigMPI_Op_has_bigop(MPI_Op op)
+{
+    if (op==MPI_MAX  || op==MPI_MIN  || op==MPI_SUM  || op==MPI_PROD   ||
+        op==MPI_LAND || op==MPI_BAND || op==MPI_LOR  || op==MPI_BOR    ||
+        op==MPI_LXOR || op==MPI_BXOR || op==MPI_MAXLOC || op==MPI_MINLOC) {
+        return 1;
+    }
 
-#endif /* BIGMPI_CLEAVER */
+    int found = 0;
+    pthread_mutex_lock(&BigMPI_op_cache_lock);
+    for (int i=0; i<BIGMPI_MAX_USER_OPS && !found; i++) {
+        found = (BigMPI_user_ops[i].fn!=NULL && BigMPI_user_ops[i].op==op);
     }
+    pthread_mutex_unlock(&BigMPI_op_cache_lock);
+
+    return found;
 }
 
-/* MPI-3 Section 5.10
- * Advice to implementers:
- * The MPI_REDUCE_SCATTER_BLOCK routine is functionally equivalent to:
- * an MPI_REDUCE collective operation with count equal to recvcount*n,
- * followed by an MPI_SCATTER with sendcount equal to recvcount. */
+/* The reductions that are cleaved into native ones. */
+typedef enum { BIGMPI_REDUCE,
+               BIGMPI_ALLREDUCE,
+               BIGMPI_SCAN,
+               BIGMPI_EXSCAN } bigmpi_reduction_t;
 
-/* The previous statement is untrue when sendbuf=MPI_IN_PLACE so we
- * are forced to buffer even in the in-place case. */
+/* Starts a native reduction of n elements (or performs it, without MPI-3).
+ * in may be MPI_IN_PLACE, except at the non-roots of a reduction to root. */
+static int BigMPI_Reduction_native(bigmpi_reduction_t kind, const void * in, void * out, int n,
+                                   MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm,
+                                   MPI_Request * req)
+{
+    int rc = MPI_SUCCESS;
+#if MPI_VERSION >= 3
+    switch (kind) {
+        case BIGMPI_REDUCE:
+            rc = MPI_Ireduce(in, out, n, datatype, op, root, comm, req);
+            break;
+        case BIGMPI_ALLREDUCE:
+            rc = MPI_Iallreduce(in, out, n, datatype, op, comm, req);
+            break;
+        case BIGMPI_SCAN:
+            rc = MPI_Iscan(in, out, n, datatype, op, comm, req);
+            break;
+        case BIGMPI_EXSCAN:
+            rc = MPI_Iexscan(in, out, n, datatype, op, comm, req);
+            break;
+    }
+#else
+    switch (kind) {
+        case BIGMPI_REDUCE:
+            rc = MPI_Reduce((void*)in, out, n, datatype, op, root, comm);
+            break;
+        case BIGMPI_ALLREDUCE:
+            rc = MPI_Allreduce((void*)in, out, n, datatype, op, comm);
+            break;
+        case BIGMPI_SCAN:
+            rc = MPI_Scan((void*)in, out, n, datatype, op, comm);
+            break;
+        case BIGMPI_EXSCAN:
+            rc = MPI_Exscan((void*)in, out, n, datatype, op, comm);
+            break;
+    }
+    *req = MPI_REQUEST_NULL;
+#endif
+    return rc;
+}
 
-int MPIX_Reduce_scatter_block_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count recvcount,
-                                MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+/* The input of the chunk at offset of a cleaved reduction, as the native reduction wants it.
+ * Non-roots may pass MPI_IN_PLACE to a reduction to root, too, in which case their input is in recvbuf. */
+static const void * BigMPI_Reduction_input(bigmpi_reduction_t kind, const void * sendbuf, void * recvbuf,
+                                           MPI_Count offset, MPI_Aint extent, int inplace_root)
 {
-    if (likely (recvcount <= bigmpi_int_max )) {
-        return MPI_Reduce_scatter_block(sendbuf, recvbuf, (int)recvcount, datatype, op, comm);
+    if (sendbuf!=MPI_IN_PLACE) {
+        return sendbuf+offset*extent;
+    } else if (kind!=BIGMPI_REDUCE || inplace_root) {
+        return MPI_IN_PLACE;
     } else {
-        int root = 0;
+        return recvbuf+offset*extent;
+    }
+}
 
-        int commsize;
-        MPI_Comm_size(comm, &commsize);
-        MPI_Count sendcount = recvcount * commsize;
+/* Cleaves a large reduction into native reductions of at most BIGMPI_PIPELINE_CHUNK
+ * bytes.  With MPI-3, these are nonblocking and BIGMPI_PIPELINE_DEPTH of them are
+ * in flight, so the transfer of one chunk overlaps with the reduction of the others.
+ * root is only significant for BIGMPI_REDUCE. */
+static int BigMPI_Reduce_cleaved(bigmpi_reduction_t kind, BIGMPI_CONST void *sendbuf, void *recvbuf,
+                                 MPI_Count count, MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm)
+{
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(datatype, &lb, &extent);
 
-        MPI_Aint lb /* unused */, extent;
-        MPI_Type_get_extent(datatype, &lb, &extent);
-        MPI_Aint buf_size = (MPI_Aint)sendcount * extent;
+    MPI_Count chunk = BigMPI_Get_pipeline_chunk()/extent;
+    if (chunk < 1) chunk = 1;
+    if (chunk > bigmpi_int_max) chunk = bigmpi_int_max;
 
-        void * tempbuf = NULL;
-        MPI_Alloc_mem(buf_size, MPI_INFO_NULL, &tempbuf);
-        assert(tempbuf!=NULL);
+    int inplace_root = 0;
+    if (sendbuf==MPI_IN_PLACE && kind==BIGMPI_REDUCE) {
+        int commrank;
+        MPI_Comm_rank(comm, &commrank);
+        inplace_root = (commrank==root);
+    }
 
-        MPIX_Reduce_x(sendbuf==MPI_IN_PLACE ? recvbuf : sendbuf,
-                      tempbuf, sendcount, datatype, op, root, comm);
-        MPIX_Scatter_x(tempbuf, recvcount, datatype, recvbuf, recvcount, datatype, root, comm);
+    int depth = 1;
+#if MPI_VERSION >= 3
+    depth = BigMPI_Get_pipeline_depth();
+#endif
+    MPI_Request * reqs = malloc(depth*sizeof(MPI_Request)); assert(reqs!=NULL);
+    for (int i=0; i<depth; i++) {
+        reqs[i] = MPI_REQUEST_NULL;
+    }
 
-        MPI_Free_mem(&tempbuf);
+    int rc = MPI_SUCCESS;
+    MPI_Count nchunks = (count+chunk-1)/chunk;
+    for (MPI_Count i=0; i<nchunks && rc==MPI_SUCCESS; i++) {
+        MPI_Count offset = i*chunk;
+        int n = (int)(count-offset < chunk ? count-offset : chunk);
+        MPI_Request * req = &reqs[i%depth];
+        rc = MPI_Wait(req, MPI_STATUS_IGNORE);
+        if (rc!=MPI_SUCCESS) break;
+        rc = BigMPI_Reduction_native(kind, BigMPI_Reduction_input(kind, sendbuf, recvbuf, offset, extent, inplace_root),
+                                     recvbuf+offset*extent, n, datatype, op, root, comm, req);
     }
-    return MPI_SUCCESS;
+
+    MPI_Waitall(depth, reqs, MPI_STATUSES_IGNORE);
+    free(reqs);
+
+    return rc;
 }
 
 #if MPI_VERSION >= 3
 
-int MPIX_Ireduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
-                   MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm, MPI_Request * req)
+/* Starts all chunks of a cleaved reduction at once and hands them to a BigMPI request,
+ * which completes once the last one has.  This requires asynchronous progress (see
+ * progress.c), because nobody calls into BigMPI until the user waits on the request. */
+static int BigMPI_Ireduce_cleaved(bigmpi_reduction_t kind, BIGMPI_CONST void *sendbuf, void *recvbuf,
+                                  MPI_Count count, MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm,
+                                  MPI_Request * request)
 {
-    if (likely (count <= bigmpi_int_max )) {
-        return MPI_Ireduce(sendbuf, recvbuf, (int)count, datatype, op, root, comm, req);
-    } else {
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(datatype, &lb, &extent);
 
-        MPI_Datatype bigtype;
-        BigMPI_Type_contiguous(0,count, datatype, &bigtype);
-        MPI_Type_commit(&bigtype);
+    MPI_Count chunk = BigMPI_Get_pipeline_chunk()/extent;
+    if (chunk < 1) chunk = 1;
+    if (chunk > bigmpi_int_max) chunk = bigmpi_int_max;
+    if (chunk < count/bigmpi_int_max+1) chunk = count/bigmpi_int_max+1;
+    int nchunks = (int)((count+chunk-1)/chunk);
 
-        MPI_Op bigop;
-        BigMPI_Op_create(op, &bigop);
+    int inplace_root = 0;
+    if (sendbuf==MPI_IN_PLACE && kind==BIGMPI_REDUCE) {
+        int commrank;
+        MPI_Comm_rank(comm, &commrank);
+        inplace_root = (commrank==root);
+    }
 
-        if (sendbuf==MPI_IN_PLACE)
-            BigMPI_Error("BigMPI does not support in-place here yet.  Sorry. \n");
+    bigmpi_request_t * req = BigMPI_Request_create(nchunks);
 
-        int rc = MPI_Ireduce(sendbuf, recvbuf, 1, bigtype, bigop, root, comm, req);
+    int rc = MPI_SUCCESS;
+    for (int i=0; i<nchunks && rc==MPI_SUCCESS; i++) {
+        MPI_Count offset = (MPI_Count)i*chunk;
+        int n = (int)(count-offset < chunk ? count-offset : chunk);
+        rc = BigMPI_Reduction_native(kind, BigMPI_Reduction_input(kind, sendbuf, recvbuf, offset, extent, inplace_root),
+                                     recvbuf+offset*extent, n, datatype, op, root, comm, &req->reqs[i]);
+    }
 
-        MPI_Type_free(&bigtype);
-        MPI_Op_free(&bigop);
+    int rc2 = BigMPI_Request_start(req, request);
+    return (rc==MPI_SUCCESS) ? rc2 : rc;
+}
 
-        return rc;
+#endif
+
+#ifndef BIGMPI_CLEAVER
+
+/* Reduces to root with a binomial tree on the private communicator of comm, one
+ * chunk of at most BIGMPI_PIPELINE_CHUNK bytes at a time.  Unlike a big op, for
+ * which MPI allocates temporaries of the size of the whole vector, this needs
+ * scratch space for one chunk at the root and for two chunks at the other
+ * processes with children (none at the leaves).  In particular, an in-place
+ * reduction does not need a copy of the vector.  Only commutative ops may be used. */
+static int BigMPI_Reduce_binomial(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                                  MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm)
+{
+    bigmpi_context_t * ctx = BigMPI_Get_context(comm);
+    int size = ctx->size;
+    int rank;
+    MPI_Comm_rank(ctx->dup, &rank);
+
+    /* Non-roots may pass MPI_IN_PLACE, too, in which case their input is in recvbuf. */
+    void * in = (sendbuf==MPI_IN_PLACE) ? recvbuf : (void*)sendbuf;
+
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(datatype, &lb, &extent);
+
+    MPI_Count chunk = BigMPI_Get_pipeline_chunk()/extent;
+    if (chunk < 1) chunk = 1;
+    if (chunk > bigmpi_int_max) chunk = bigmpi_int_max;
+
+    /* The children of vrank are vrank+mask for all masks below its lowest set bit. */
+    int vrank = (rank-root+size)%size;
+    int lowbit = 1;
+    while (lowbit < size && !(vrank & lowbit)) {
+        lowbit <<= 1;
+    }
+    int parent    = (vrank==0) ? MPI_PROC_NULL : (vrank-lowbit+root)%size;
+    int nchildren = 0;
+    for (int mask=1; mask<lowbit && vrank+mask<size; mask<<=1) {
+        nchildren++;
+    }
+
+    void * tmp = NULL;
+    void * acc = NULL;
+    if (nchildren > 0) {
+        void * scratch = BigMPI_Get_scratch(ctx, (vrank==0 ? 1 : 2)*chunk*extent);
+        tmp = scratch;
+        acc = (vrank==0) ? NULL : scratch+chunk*extent;
+    }
+
+    int rc = MPI_SUCCESS;
+    for (MPI_Count offset=0; offset<count && rc==MPI_SUCCESS; offset+=chunk) {
+        int n = (int)(count-offset < chunk ? count-offset : chunk);
+
+        /* The root accumulates into recvbuf, the leaves send their input as is. */
+        void * sum;
+        if (vrank==0) {
+            sum = recvbuf+offset*extent;
+            if (sendbuf!=MPI_IN_PLACE) {
+                memcpy(sum, in+offset*extent, (size_t)n*extent);
+            }
+        } else if (nchildren > 0) {
+            sum = acc;
+            memcpy(sum, in+offset*extent, (size_t)n*extent);
+        } else {
+            sum = in+offset*extent;
+        }
 
+        /* Use tag=0 because there is perfect pair-wise matching. */
+        for (int mask=1, c=0; c<nchildren && rc==MPI_SUCCESS; mask<<=1, c++) {
+            rc = MPI_Recv(tmp, n, datatype, (vrank+mask+root)%size, 0 /* tag */, ctx->dup, MPI_STATUS_IGNORE);
+            if (rc==MPI_SUCCESS) {
+                rc = MPIX_Reduce_local_x(tmp, sum, n, datatype, op);
+            }
+        }
+        if (parent!=MPI_PROC_NULL && rc==MPI_SUCCESS) {
+            rc = MPI_Send(sum, n, datatype, parent, 0 /* tag */, ctx->dup);
+        }
     }
+
+    return rc;
 }
 
-int MPIX_Iallreduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
-                     MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request * req)
+#endif /* BIGMPI_CLEAVER */
+
+/* BIGMPI_REPRODUCIBLE=1 fixes the order in which MPIX_Reduce_x and MPIX_Allreduce_x
+ * combine the contributions of the processes where it matters, i.e. for sums and
+ * products of floating-point numbers, so that the result only depends on the
+ * input, the size of the communicator and the order of its ranks. */
+static pthread_once_t BigMPI_reproducible_is_initialized = PTHREAD_ONCE_INIT;
+static int BigMPI_reproducible = 0;
+
+static void BigMPI_Detect_reproducible(void)
 {
-    if (likely (count <= bigmpi_int_max )) {
-        return MPI_Iallreduce(sendbuf, recvbuf, (int)count, datatype, op, comm, req);
+    char * env_var = getenv("BIGMPI_REPRODUCIBLE");
+    if (env_var != NULL) {
+        BigMPI_reproducible = atoi(env_var);
+    }
+}
+
+static int BigMPI_Reproducible(MPI_Datatype datatype, MPI_Op op)
+{
+    pthread_once(&BigMPI_reproducible_is_initialized, BigMPI_Detect_reproducible);
+
+    if (likely (!BigMPI_reproducible)) {
+        return 0;
+    }
+
+    return (op==MPI_SUM || op==MPI_PROD) &&
+           (datatype==MPI_FLOAT || datatype==MPI_DOUBLE || datatype==MPI_LONG_DOUBLE ||
+            datatype==MPI_C_FLOAT_COMPLEX || datatype==MPI_C_DOUBLE_COMPLEX ||
+            datatype==MPI_C_LONG_DOUBLE_COMPLEX);
+}
+
+/* The wire formats of MPIX_Comm_set_wire_format_x.  A bfloat16 is the upper half
+ * of a float, rounded to nearest even, so it has the range of a float and 8 bits of
+ * precision.  Doubles become floats first.  Values that are representable in the
+ * wire format survive the round trip unchanged. */
+
+static uint16_t BigMPI_Float_to_bfloat16(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    if ((u & 0x7fffffffu) > 0x7f800000u) {
+        return (uint16_t)((u >> 16) | 0x40); /* keep NaNs quiet */
+    }
+    u += 0x7fffu + ((u >> 16) & 1u);
+    return (uint16_t)(u >> 16);
+}
+
+static float BigMPI_Bfloat16_to_float(uint16_t h)
+{
+    uint32_t u = (uint32_t)h << 16;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+/* The type that elements of datatype travel as.  Only MPI_DOUBLE and MPI_FLOAT have a reduced one. */
+static MPI_Datatype BigMPI_Wire_type(int wire, MPI_Datatype datatype)
+{
+    switch (wire) {
+        case MPIX_WIRE_FLOAT:    return MPI_FLOAT;
+        case MPIX_WIRE_BFLOAT16: return MPI_UINT16_T;
+        default:                 return datatype;
+    }
+}
+
+static void BigMPI_Wire_pack(int wire, MPI_Datatype datatype, const void * in, void * out, int n)
+{
+    if (datatype==MPI_DOUBLE && wire==MPIX_WIRE_FLOAT) {
+        const double * x = in;
+        float * y = out;
+        for (int i=0; i<n; i++) y[i] = (float)x[i];
+    } else if (datatype==MPI_DOUBLE) {
+        const double * x = in;
+        uint16_t * y = out;
+        for (int i=0; i<n; i++) y[i] = BigMPI_Float_to_bfloat16((float)x[i]);
     } else {
+        const float * x = in;
+        uint16_t * y = out;
+        for (int i=0; i<n; i++) y[i] = BigMPI_Float_to_bfloat16(x[i]);
+    }
+}
 
-        MPI_Datatype bigtype;
-        BigMPI_Type_contiguous(0,count, datatype, &bigtype);
-        MPI_Type_commit(&bigtype);
+/* Widens n elements in the wire format into out, adding them to it if accumulate is set. */
+static void BigMPI_Wire_unpack(int wire, MPI_Datatype datatype, const void * in, void * out, int n, int accumulate)
+{
+    if (datatype==MPI_DOUBLE && wire==MPIX_WIRE_FLOAT) {
+        const float * x = in;
+        double * y = out;
+        if (accumulate) for (int i=0; i<n; i++) y[i] += x[i];
+        else            for (int i=0; i<n; i++) y[i]  = x[i];
+    } else if (datatype==MPI_DOUBLE) {
+        const uint16_t * x = in;
+        double * y = out;
+        if (accumulate) for (int i=0; i<n; i++) y[i] += BigMPI_Bfloat16_to_float(x[i]);
+        else            for (int i=0; i<n; i++) y[i]  = BigMPI_Bfloat16_to_float(x[i]);
+    } else {
+        const uint16_t * x = in;
+        float * y = out;
+        if (accumulate) for (int i=0; i<n; i++) y[i] += BigMPI_Bfloat16_to_float(x[i]);
+        else            for (int i=0; i<n; i++) y[i]  = BigMPI_Bfloat16_to_float(x[i]);
+    }
+}
 
-        MPI_Op bigop;
-        BigMPI_Op_create(op, &bigop);
+/* Returns the wire format of a sum over comm, which is MPIX_WIRE_FULL unless one was set
+ * with MPIX_Comm_set_wire_format_x.  It does not create the context of comm, because
+ * setting a wire format does, so this is local and every process gets the same answer. */
+static int BigMPI_Get_wire_format(MPI_Comm comm, MPI_Datatype datatype, MPI_Op op)
+{
+    if (likely (op!=MPI_SUM || (datatype!=MPI_DOUBLE && datatype!=MPI_FLOAT))) {
+        return MPIX_WIRE_FULL;
+    }
 
-        if (sendbuf==MPI_IN_PLACE)
-            BigMPI_Error("BigMPI does not support in-place here yet.  Sorry. \n");
+    bigmpi_context_t * ctx = BigMPI_Find_context(comm);
+    if (ctx==NULL || (datatype==MPI_FLOAT && ctx->wire==MPIX_WIRE_FLOAT)) {
+        return MPIX_WIRE_FULL;
+    }
+    return ctx->wire;
+}
 
-        int rc = MPI_Iallreduce(sendbuf, recvbuf, 1, bigtype, bigop, comm, req);
+/*
+ * Synopsis
+ *
+ * int MPIX_Comm_set_wire_format_x(MPI_Comm comm, int format)
+ *
+ *  Input Parameters
+ *
+ *   comm               communicator
+ *   format             MPIX_WIRE_FULL, MPIX_WIRE_FLOAT or MPIX_WIRE_BFLOAT16
+ *
+ * Notes
+ *
+ *   Selects the format in which MPIX_Allreduce_x moves MPI_SUM reductions of
+ *   MPI_DOUBLE (float or bfloat16) and MPI_FLOAT (bfloat16) on comm.  Partial
+ *   sums are accumulated in the full precision of the datatype.  See README.md
+ *   for the error bounds.  Collective the first time it is called on comm, and
+ *   all processes have to select the same format before each allreduce, so it
+ *   can be changed around a single call, too.
+ *
+ */
+int MPIX_Comm_set_wire_format_x(MPI_Comm comm, int format)
+{
+    if (format!=MPIX_WIRE_FULL && format!=MPIX_WIRE_FLOAT && format!=MPIX_WIRE_BFLOAT16) {
+        BigMPI_Error("Unknown wire format %d. \n", format);
+    }
+    BigMPI_Get_context(comm)->wire = format;
+    return MPI_SUCCESS;
+}
 
-        MPI_Type_free(&bigtype);
-        MPI_Op_free(&bigop);
+/* Exchanges sendcount elements at sendptr for recvcount elements of partner, which
+ * are reduced into recvptr, or just stored there if op is MPI_OP_NULL.  This moves at
+ * most chunk elements at a time through scratch, in the wire format wire, so partner
+ * has to call it with the counts swapped.  scratch has to hold chunk elements. */
+static int BigMPI_Sendrecv_reduce(const void * sendptr, MPI_Count sendcount,
+                                  void * recvptr, MPI_Count recvcount,
+                                  MPI_Datatype datatype, MPI_Aint extent, MPI_Op op, int wire, int partner,
+                                  void * scratch, MPI_Count chunk, MPI_Comm comm)
+{
+    /* A reduced wire format takes at most half the space, so the elements to send and
+     * the elements received share scratch. */
+    MPI_Datatype wiretype = BigMPI_Wire_type(wire, datatype);
+    int wiresize;
+    MPI_Type_size(wiretype, &wiresize);
+    void * packed = scratch;
+    void * wirebuf = (wire==MPIX_WIRE_FULL) ? scratch : scratch+chunk*wiresize;
 
-        return rc;
+    int rc = MPI_SUCCESS;
+    MPI_Count n = (sendcount > recvcount) ? sendcount : recvcount;
+    for (MPI_Count i=0; i<n && rc==MPI_SUCCESS; i+=chunk) {
+        int s = (int)(sendcount-i >= chunk ? chunk : (sendcount > i ? sendcount-i : 0));
+        int r = (int)(recvcount-i >= chunk ? chunk : (recvcount > i ? recvcount-i : 0));
+        const void * sptr = (s > 0) ? sendptr+i*extent : NULL;
+        if (wire!=MPIX_WIRE_FULL && s > 0) {
+            BigMPI_Wire_pack(wire, datatype, sptr, packed, s);
+            sptr = packed;
+        }
+        void * rptr = (wire==MPIX_WIRE_FULL && op==MPI_OP_NULL) ? recvptr+i*extent : wirebuf;
+        /* Use tag=0 because there is perfect pair-wise matching. */
+        rc = MPI_Sendrecv((void*)sptr, s, wiretype, partner, 0 /* tag */,
+                          rptr, r, wiretype, partner, 0 /* tag */, comm, MPI_STATUS_IGNORE);
+        if (rc==MPI_SUCCESS && r > 0) {
+            if (wire!=MPIX_WIRE_FULL) {
+                BigMPI_Wire_unpack(wire, datatype, wirebuf, recvptr+i*extent, r, op!=MPI_OP_NULL);
+            } else if (op!=MPI_OP_NULL) {
+                rc = MPIX_Reduce_local_x(wirebuf, recvptr+i*extent, r, datatype, op);
+            }
+        }
+    }
+    return rc;
+}
+
+/* Rabenseifner's allreduce (see e.g. Thakur, Rabenseifner and Gropp, IJHPCA 2005)
+ * on the private communicator of comm.  The first 2*rem processes, where rem is
+ * the distance of the communicator size to the next lower power of two, first
+ * reduce pairwise into the odd ones and get the result back at the end.
+ * The reduction needs a scratch buffer of BIGMPI_PIPELINE_CHUNK bytes only.
+ * Only commutative ops may be used because the order of the operands differs
+ * between processes.
+ *
+ * With a root other than MPI_PROC_NULL, the reduced halves are gathered to the
+ * process that would have finished the allreduce first and sent to root from there.
+ * The processes other than root then reduce into a temporary copy, which is only as
+ * large as the part of the vector they need to hold.
+ * Either way, every element is reduced by the same tree of comm ranks, whatever
+ * the root, the mapping of the processes or the timing of the messages, which is
+ * what BIGMPI_REPRODUCIBLE relies on.
+ *
+ * An allreduce may move the data in a reduced wire format (see BigMPI_Get_wire_format).
+ * Every process then rounds its block of the result to that format before the
+ * allgather, so that all of them end up with the same values. */
+static int BigMPI_Reduce_rabenseifner(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                                      MPI_Datatype datatype, MPI_Op op, int root, int wire, MPI_Comm comm)
+{
+    assert(wire==MPIX_WIRE_FULL || root==MPI_PROC_NULL);
+
+    bigmpi_context_t * ctx = BigMPI_Get_context(comm);
+    int size = ctx->size;
+    int rank;
+    MPI_Comm_rank(ctx->dup, &rank);
+
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(datatype, &lb, &extent);
+
+    MPI_Count chunk = BigMPI_Get_pipeline_chunk()/extent;
+    if (chunk < 1) chunk = 1;
+    if (chunk > bigmpi_int_max) chunk = bigmpi_int_max;
+    void * scratch = BigMPI_Get_scratch(ctx, chunk*extent);
+
+    int pof2 = 1, nsteps = 0;
+    while (2*pof2 <= size) {
+        pof2 *= 2;
+        nsteps++;
+    }
+    int rem = size - pof2;
+
+    /* buf holds the elements from origin on.  A process other than root only needs a
+     * copy of what it reduces into: none if it just sends its input to its partner in the
+     * first step, the half that it keeps in the first halving step if it does not gather
+     * the result either, and the whole vector otherwise.  Non-roots may pass MPI_IN_PLACE,
+     * too, in which case their input is in recvbuf. */
+    const void * in = (sendbuf==MPI_IN_PLACE) ? recvbuf : sendbuf;
+    void * buf = recvbuf, * copy = NULL;
+    MPI_Count origin = 0;
+    int half = 0;
+    if (root!=MPI_PROC_NULL && rank!=root) {
+        if (rank < 2*rem && rank%2==0) {
+            buf = (void*)in;
+        } else {
+            MPI_Count copylo = 0, copyhi = count;
+            if (rank >= 2*rem && rank-rem != 0) {
+                half = 1;
+                copylo = ((rank-rem) & (pof2>>1)) ? count/2 : 0;
+                copyhi = ((rank-rem) & (pof2>>1)) ? count : count/2;
+            }
+            MPI_Alloc_mem((copyhi-copylo)*extent, MPI_INFO_NULL, &copy);
+            assert(copy!=NULL);
+            memcpy(copy, in+copylo*extent, (size_t)(copyhi-copylo)*extent);
+            buf = copy;
+            origin = copylo;
+        }
+    } else if (sendbuf!=MPI_IN_PLACE) {
+        memcpy(buf, sendbuf, (size_t)count*extent);
+    }
+
+    int rc = MPI_SUCCESS;
+
+    int newrank;
+    if (rank < 2*rem) {
+        if (rank%2==0) {
+            rc = BigMPI_Sendrecv_reduce(buf, count, NULL, 0, datatype, extent, op, wire, rank+1,
+                                        scratch, chunk, ctx->dup);
+            newrank = -1;
+        } else {
+            rc = BigMPI_Sendrecv_reduce(NULL, 0, buf, count, datatype, extent, op, wire, rank-1,
+                                        scratch, chunk, ctx->dup);
+            newrank = rank/2;
+        }
+    } else {
+        newrank = rank-rem;
+    }
+
+    if (newrank != -1) {
+        /* [lo[s],hi[s]) is the range of elements before step s of the reduce-scatter. */
+        MPI_Count * lo = malloc(2*(nsteps+1)*sizeof(MPI_Count)); assert(lo!=NULL);
+        MPI_Count * hi = lo+nsteps+1;
+
+        MPI_Count mylo = 0, myhi = count;
+        for (int s=0; s<nsteps && rc==MPI_SUCCESS; s++) {
+            int mask = pof2>>(s+1);
+            int newpartner = newrank ^ mask;
+            int partner = (newpartner < rem) ? 2*newpartner+1 : newpartner+rem;
+            MPI_Count mid = mylo+(myhi-mylo)/2;
+            lo[s] = mylo;
+            hi[s] = myhi;
+            /* With half a copy, the other half is sent straight from the input. */
+            if (newrank & mask) {
+                /* keep the upper half */
+                const void * sendptr = (half && s==0) ? in+mylo*extent : buf+(mylo-origin)*extent;
+                rc = BigMPI_Sendrecv_reduce(sendptr, mid-mylo, buf+(mid-origin)*extent, myhi-mid,
+                                            datatype, extent, op, wire, partner, scratch, chunk, ctx->dup);
+                mylo = mid;
+            } else {
+                /* keep the lower half */
+                const void * sendptr = (half && s==0) ? in+mid*extent : buf+(mid-origin)*extent;
+                rc = BigMPI_Sendrecv_reduce(sendptr, myhi-mid, buf+(mylo-origin)*extent, mid-mylo,
+                                            datatype, extent, op, wire, partner, scratch, chunk, ctx->dup);
+                myhi = mid;
+            }
+        }
+
+        if (wire!=MPIX_WIRE_FULL) {
+            for (MPI_Count i=mylo; i<myhi; i+=chunk) {
+                int n = (int)(myhi-i < chunk ? myhi-i : chunk);
+                BigMPI_Wire_pack(wire, datatype, buf+(i-origin)*extent, scratch, n);
+                BigMPI_Wire_unpack(wire, datatype, scratch, buf+(i-origin)*extent, n, 0);
+            }
+        }
+
+        /* Undo the halving steps in reverse order to gather the result, either
+         * everywhere or, for a reduction to root, only at newrank 0. */
+        for (int s=nsteps-1; s>=0 && rc==MPI_SUCCESS; s--) {
+            int mask = pof2>>(s+1);
+            int newpartner = newrank ^ mask;
+            int partner = (newpartner < rem) ? 2*newpartner+1 : newpartner+rem;
+            MPI_Count otherlo = (newrank & mask) ? lo[s] : myhi;
+            MPI_Count otherhi = (newrank & mask) ? mylo  : hi[s];
+            if (wire!=MPIX_WIRE_FULL) {
+                rc = BigMPI_Sendrecv_reduce(buf+(mylo-origin)*extent, myhi-mylo, buf+(otherlo-origin)*extent, otherhi-otherlo,
+                                            datatype, extent, MPI_OP_NULL, wire, partner, scratch, chunk, ctx->dup);
+            } else if (root==MPI_PROC_NULL) {
+                rc = MPIX_Sendrecv_x(buf+(mylo-origin)*extent, myhi-mylo, datatype, partner, 0 /* tag */,
+                                     buf+(otherlo-origin)*extent, otherhi-otherlo, datatype, partner, 0 /* tag */,
+                                     ctx->dup, MPI_STATUS_IGNORE);
+            } else if (newrank & mask) {
+                rc = MPIX_Send_x(buf+(mylo-origin)*extent, myhi-mylo, datatype, partner, 0 /* tag */, ctx->dup);
+                break;
+            } else {
+                rc = MPIX_Recv_x(buf+(otherlo-origin)*extent, otherhi-otherlo, datatype, partner, 0 /* tag */,
+                                 ctx->dup, MPI_STATUS_IGNORE);
+            }
+            mylo = lo[s];
+            myhi = hi[s];
+        }
+
+        free(lo);
+    }
+
+    if (root==MPI_PROC_NULL) {
+        if (rank < 2*rem && rc==MPI_SUCCESS && wire!=MPIX_WIRE_FULL) {
+            rc = BigMPI_Sendrecv_reduce(buf, (rank%2==0) ? 0 : count, buf, (rank%2==0) ? count : 0,
+                                        datatype, extent, MPI_OP_NULL, wire, (rank%2==0) ? rank+1 : rank-1,
+                                        scratch, chunk, ctx->dup);
+        } else if (rank < 2*rem && rc==MPI_SUCCESS) {
+            if (rank%2==0) {
+                rc = MPIX_Recv_x(buf, count, datatype, rank+1, 0 /* tag */, ctx->dup, MPI_STATUS_IGNORE);
+            } else {
+                rc = MPIX_Send_x(buf, count, datatype, rank-1, 0 /* tag */, ctx->dup);
+            }
+        }
+    } else {
+        int first = (rem > 0) ? 1 : 0; /* the process of newrank 0 */
+        if (first!=root && rc==MPI_SUCCESS) {
+            if (rank==first) {
+                rc = MPIX_Send_x(buf, count, datatype, root, 0 /* tag */, ctx->dup);
+            } else if (rank==root) {
+                rc = MPIX_Recv_x(buf, count, datatype, first, 0 /* tag */, ctx->dup, MPI_STATUS_IGNORE);
+            }
+        }
+        if (copy!=NULL) {
+            MPI_Free_mem(copy);
+        }
+    }
+
+    return rc;
+}
+
+int MPIX_Reduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                  MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm)
+{
+    if (unlikely (BigMPI_Reproducible(datatype, op))) {
+        return BigMPI_Reduce_rabenseifner(sendbuf, recvbuf, count, datatype, op, root, MPIX_WIRE_FULL, comm);
+    }
+
+    if (likely (count <= bigmpi_int_max )) {
+        return MPI_Reduce(sendbuf, recvbuf, (int)count, datatype, op, root, comm);
+    } else {
+#ifdef BIGMPI_CLEAVER
+        return BigMPI_Reduce_cleaved(BIGMPI_REDUCE, sendbuf, recvbuf, count, datatype, op, root, comm);
+#else /* BIGMPI_CLEAVER */
+
+        /* Only the root knows whether the reduction is in place, so every
+         * reduction with a commutative op is done with bounded scratch space. */
+        int commute;
+        MPI_Op_commutative(op, &commute);
+        if (commute) {
+            return BigMPI_Reduce_binomial(sendbuf, recvbuf, count, datatype, op, root, comm);
+        }
+
+        MPI_Datatype bigtype;
+        BigMPI_Type_contiguous(0,count, datatype, &bigtype);
+        MPI_Type_commit(&bigtype);
+
+        MPI_Op bigop = BigMPI_Op_get_cached(op);
+
+        /* Non-roots may pass MPI_IN_PLACE, too, in which case their input is in recvbuf. */
+        if (sendbuf==MPI_IN_PLACE) {
+            int commrank;
+            MPI_Comm_rank(comm, &commrank);
+            if (commrank!=root) {
+                sendbuf = recvbuf;
+            }
+        }
+
+        int rc = MPI_Reduce(sendbuf, recvbuf, 1, bigtype, bigop, root, comm);
+
+        MPI_Type_free(&bigtype);
+
+        return rc;
+
+#endif /* BIGMPI_CLEAVER */
+    }
+}
+
+#if MPI_VERSION >= 3
+
+/* Stripes a large allreduce over the stripe communicators of comm (see context.c).
+ * Every piece is a native reduction with an int count, so built-in ops keep their speed. */
+static int BigMPI_Allreduce_striped(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                                    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, int nstripes)
+{
+    MPI_Comm * stripes = BigMPI_Get_stripe_comms(BigMPI_Get_context(comm));
+
+    MPI_Count chunk = (count+nstripes-1)/nstripes;
+    if (chunk > bigmpi_int_max) chunk = bigmpi_int_max;
+    int nchunks = (int)((count+chunk-1)/chunk);
+
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(datatype, &lb, &extent);
+
+    bigmpi_request_t * req = BigMPI_Request_create(nchunks);
+
+    int rc = MPI_SUCCESS;
+    for (int i=0; i<nchunks && rc==MPI_SUCCESS; i++) {
+        MPI_Count offset = (MPI_Count)i*chunk;
+        int n = (int)(count-offset < chunk ? count-offset : chunk);
+        rc = MPI_Iallreduce(sendbuf==MPI_IN_PLACE ? MPI_IN_PLACE : (const char*)sendbuf+offset*extent,
+                            (char*)recvbuf+offset*extent, n, datatype, op,
+                            stripes[i%nstripes], &req->reqs[i]);
+    }
+
+    BigMPI_Request_wait(req);
+    return rc;
+}
+
+#endif
+
+/* The algorithms that MPIX_Allreduce_x can use for large counts:
+ *
+ *  - CLEAVER:      native allreduces of BIGMPI_PIPELINE_CHUNK bytes (see BigMPI_Reduce_cleaved),
+ *  - BIGOP:        one native allreduce of a single element of a large-count type
+ *                  with a user-defined op, which MPI cannot segment,
+ *  - RABENSEIFNER: reduce-scatter by recursive halving followed by allgather by
+ *                  recursive doubling, implemented by BigMPI, which moves about
+ *                  2N bytes per process for a vector of N bytes,
+ *  - RING:         segmented ring reduce-scatter followed by a ring allgather,
+ *                  implemented by BigMPI, which also moves about 2N bytes per
+ *                  process and overlaps the local reductions with communication.
+ *
+ * BIGMPI_ALLREDUCE_METHOD selects one of them.  The default is CLEAVER if BigMPI
+ * is configured with pipelined reductions and RABENSEIFNER otherwise. */
+
+typedef enum { ALLREDUCE_CLEAVER,
+               ALLREDUCE_BIGOP,
+               ALLREDUCE_RABENSEIFNER,
+               ALLREDUCE_RING } bigmpi_allreduce_method_t;
+
+static pthread_once_t BigMPI_allreduce_method_is_initialized = PTHREAD_ONCE_INIT;
+static bigmpi_allreduce_method_t BigMPI_allreduce_method;
+
+static void BigMPI_Detect_allreduce_method(void)
+{
+#ifdef BIGMPI_CLEAVER
+    BigMPI_allreduce_method = ALLREDUCE_CLEAVER;
+#else
+    BigMPI_allreduce_method = ALLREDUCE_RABENSEIFNER;
+#endif
+
+    char * env_var = getenv("BIGMPI_ALLREDUCE_METHOD");
+    if (env_var != NULL) {
+        if (strcmp(env_var, "CLEAVER")==0) {
+            BigMPI_allreduce_method = ALLREDUCE_CLEAVER;
+        } else if (strcmp(env_var, "BIGOP")==0) {
+            BigMPI_allreduce_method = ALLREDUCE_BIGOP;
+        } else if (strcmp(env_var, "RABENSEIFNER")==0) {
+            BigMPI_allreduce_method = ALLREDUCE_RABENSEIFNER;
+        } else if (strcmp(env_var, "RING")==0) {
+            BigMPI_allreduce_method = ALLREDUCE_RING;
+        } else {
+            fprintf(stderr, "Unknown value \"%s\" for environment variable BIGMPI_ALLREDUCE_METHOD\n", env_var);
+        }
+    }
+}
+
+static int BigMPI_Allreduce_bigop(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+    MPI_Datatype bigtype;
+    BigMPI_Type_contiguous(0,count, datatype, &bigtype);
+    MPI_Type_commit(&bigtype);
+
+    MPI_Op bigop = BigMPI_Op_get_cached(op);
+
+    int rc = MPI_Allreduce(sendbuf, recvbuf, 1, bigtype, bigop, comm);
+
+    MPI_Type_free(&bigtype);
+
+    return rc;
+}
+
+/* Returns the index of the first element of block b when count elements are split into nblocks blocks. */
+static MPI_Count BigMPI_Block_start(MPI_Count count, int nblocks, int b)
+{
+    MPI_Count q = count/nblocks;
+    MPI_Count r = count%nblocks;
+    return q*b + (b < r ? b : r);
+}
+
+/* One reduce-scatter step of the ring allreduce: sends sendcount elements to right
+ * and reduces recvcount elements from left into recvptr.  The incoming elements
+ * arrive in segments of at most seg elements in the two halves of scratch, so the
+ * reduction of one segment overlaps with the transfer of the next one. */
+static int BigMPI_Ring_step_reduce(const void * sendptr, MPI_Count sendcount,
+                                   void * recvptr, MPI_Count recvcount,
+                                   MPI_Datatype datatype, MPI_Aint extent, MPI_Op op,
+                                   int left, int right, void * scratch, MPI_Count seg, MPI_Comm comm)
+{
+    int nsend = (int)((sendcount+seg-1)/seg);
+    int nrecv = (int)((recvcount+seg-1)/seg);
+
+    MPI_Request * sreqs = malloc(nsend*sizeof(MPI_Request)); assert(nsend==0 || sreqs!=NULL);
+    MPI_Request   rreqs[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+    void        * rbufs[2] = { scratch, scratch+seg*extent };
+
+    int rc = MPI_SUCCESS;
+
+    /* Use tag=0 because there is perfect pair-wise matching. */
+    for (int k=0; k<nsend && rc==MPI_SUCCESS; k++) {
+        int n = (int)(sendcount-k*seg < seg ? sendcount-k*seg : seg);
+        rc = MPI_Isend((void*)sendptr+k*seg*extent, n, datatype, right, 0 /* tag */, comm, &sreqs[k]);
+    }
+
+    for (int k=0; k<nrecv && rc==MPI_SUCCESS; k++) {
+        if (k==0) {
+            int n = (int)(recvcount < seg ? recvcount : seg);
+            rc = MPI_Irecv(rbufs[0], n, datatype, left, 0 /* tag */, comm, &rreqs[0]);
+        }
+        if (k+1<nrecv && rc==MPI_SUCCESS) {
+            int n = (int)(recvcount-(k+1)*seg < seg ? recvcount-(k+1)*seg : seg);
+            rc = MPI_Irecv(rbufs[(k+1)%2], n, datatype, left, 0 /* tag */, comm, &rreqs[(k+1)%2]);
+        }
+        if (rc==MPI_SUCCESS) {
+            rc = MPI_Wait(&rreqs[k%2], MPI_STATUS_IGNORE);
+        }
+        if (rc==MPI_SUCCESS) {
+            int n = (int)(recvcount-k*seg < seg ? recvcount-k*seg : seg);
+            rc = MPIX_Reduce_local_x(rbufs[k%2], recvptr+k*seg*extent, n, datatype, op);
+        }
+    }
+
+    MPI_Waitall(nsend, sreqs, MPI_STATUSES_IGNORE);
+    free(sreqs);
+
+    return rc;
+}
+
+/* The ring allreduce of deep-learning frameworks (see e.g. Patarasuk and Yuan,
+ * JPDC 2009) on the private communicator of comm: a reduce-scatter in size-1 steps
+ * around the ring of the context, which visits every node in one stretch,
+ * followed by an allgather around the same ring.  Every process sends and
+ * receives 2N(size-1)/size elements and needs a scratch buffer of
+ * BIGMPI_PIPELINE_CHUNK bytes.  Only commutative ops may be used. */
+static int BigMPI_Allreduce_ring(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                                 MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+    bigmpi_context_t * ctx = BigMPI_Get_context(comm);
+    int size = ctx->size;
+    int pos  = ctx->ring_pos;
+
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(datatype, &lb, &extent);
+
+    if (sendbuf!=MPI_IN_PLACE) {
+        memcpy(recvbuf, sendbuf, (size_t)count*extent);
+    }
+
+    MPI_Count seg = BigMPI_Get_pipeline_chunk()/(2*extent);
+    if (seg < 1) seg = 1;
+    if (seg > bigmpi_int_max) seg = bigmpi_int_max;
+    void * scratch = BigMPI_Get_scratch(ctx, 2*seg*extent);
+
+    int left  = ctx->ring[(pos+size-1)%size];
+    int right = ctx->ring[(pos+1)%size];
+
+    int rc = MPI_SUCCESS;
+
+    /* After step s, block (pos-s-1) holds the reduction over s+2 processes,
+     * so every process ends up with the full reduction of block pos+1. */
+    for (int s=0; s<size-1 && rc==MPI_SUCCESS; s++) {
+        int sb = (pos-s+size)%size;
+        int rb = (pos-s-1+size)%size;
+        MPI_Count sfirst = BigMPI_Block_start(count, size, sb);
+        MPI_Count rfirst = BigMPI_Block_start(count, size, rb);
+        rc = BigMPI_Ring_step_reduce(recvbuf+sfirst*extent, BigMPI_Block_start(count, size, sb+1)-sfirst,
+                                     recvbuf+rfirst*extent, BigMPI_Block_start(count, size, rb+1)-rfirst,
+                                     datatype, extent, op, left, right, scratch, seg, ctx->dup);
+    }
+
+    for (int s=0; s<size-1 && rc==MPI_SUCCESS; s++) {
+        int sb = (pos-s+1+size)%size;
+        int rb = (pos-s+size)%size;
+        MPI_Count sfirst = BigMPI_Block_start(count, size, sb);
+        MPI_Count rfirst = BigMPI_Block_start(count, size, rb);
+        rc = MPIX_Sendrecv_x(recvbuf+sfirst*extent, BigMPI_Block_start(count, size, sb+1)-sfirst, datatype,
+                             right, 0 /* tag */,
+                             recvbuf+rfirst*extent, BigMPI_Block_start(count, size, rb+1)-rfirst, datatype,
+                             left, 0 /* tag */, ctx->dup, MPI_STATUS_IGNORE);
+    }
+
+    return rc;
+}
+
+int MPIX_Allreduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                     MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+    int wire = BigMPI_Get_wire_format(comm, datatype, op);
+    if (unlikely (wire!=MPIX_WIRE_FULL || BigMPI_Reproducible(datatype, op))) {
+        return BigMPI_Reduce_rabenseifner(sendbuf, recvbuf, count, datatype, op, MPI_PROC_NULL, wire, comm);
+    }
+
+#if MPI_VERSION >= 3
+    int nstripes = BigMPI_Get_stripes(count, datatype);
+    if (nstripes > 1) {
+        return BigMPI_Allreduce_striped(sendbuf, recvbuf, count, datatype, op, comm, nstripes);
+    }
+#endif
+
+    if (likely (count <= bigmpi_int_max )) {
+        return MPI_Allreduce(sendbuf, recvbuf, (int)count, datatype, op, comm);
+    } else {
+        pthread_once(&BigMPI_allreduce_method_is_initialized, BigMPI_Detect_allreduce_method);
+
+        int commute;
+        MPI_Op_commutative(op, &commute);
+
+        switch (BigMPI_allreduce_method) {
+            case ALLREDUCE_RABENSEIFNER:
+                if (commute) {
+                    return BigMPI_Reduce_rabenseifner(sendbuf, recvbuf, count, datatype, op, MPI_PROC_NULL,
+                                                      MPIX_WIRE_FULL, comm);
+                }
+                return BigMPI_Allreduce_bigop(sendbuf, recvbuf, count, datatype, op, comm);
+            case ALLREDUCE_RING:
+                if (commute) {
+                    return BigMPI_Allreduce_ring(sendbuf, recvbuf, count, datatype, op, comm);
+                }
+                return BigMPI_Allreduce_bigop(sendbuf, recvbuf, count, datatype, op, comm);
+            case ALLREDUCE_BIGOP:
+                return BigMPI_Allreduce_bigop(sendbuf, recvbuf, count, datatype, op, comm);
+            case ALLREDUCE_CLEAVER:
+            default:
+                return BigMPI_Reduce_cleaved(BIGMPI_ALLREDUCE, sendbuf, recvbuf, count, datatype, op, MPI_PROC_NULL, comm);
+        }
+    }
+}
+
+/* The state of a reduce-scatter around the ring of the context of comm (see context.c).
+ * The block of rank b has counts[b] elements at displs[b] (in elements) of the input.
+ * The partial result of every block starts at the ring successor of its owner and
+ * travels once around the ring, so each process sends and receives the sum of all
+ * counts but its own and no process holds more than two chunks of BIGMPI_PIPELINE_CHUNK
+ * bytes of scratch space.  The ring is run once per chunk of the blocks. */
+typedef struct {
+    bigmpi_context_t * ctx;
+    const void       * in;
+    void             * recvbuf;
+    MPI_Datatype       datatype;
+    MPI_Op             op;
+    MPI_Aint           extent;
+    MPI_Count          chunk;
+    MPI_Count          maxcount;
+    MPI_Count          offset;    /* of the current chunk within every block */
+    int                step;      /* of the ring, 0..size-2 */
+    int                tag;
+    const void       * sendptr;
+    int                sendn;
+    void             * tmp;       /* receives the partial result of the next block */
+    void             * acc;       /* holds the partial result that is sent next */
+    MPI_Count          counts[];  /* counts[size], followed by displs[size] */
+} bigmpi_reduce_scatter_t;
+
+/* Elements of block b in the current chunk. */
+static int BigMPI_Reduce_scatter_slice(const bigmpi_reduce_scatter_t * rs, int b)
+{
+    MPI_Count left = rs->counts[b] - rs->offset;
+    return (int)(left <= 0 ? 0 : (left < rs->chunk ? left : rs->chunk));
+}
+
+/* The block whose partial result arrives in the current step. */
+static int BigMPI_Reduce_scatter_recv_block(const bigmpi_reduce_scatter_t * rs)
+{
+    int size = rs->ctx->size;
+    return rs->ctx->ring[(rs->ctx->ring_pos+2*size-rs->step-2)%size];
+}
+
+/* Posts the receive from the ring predecessor and the send to the ring successor. */
+static int BigMPI_Reduce_scatter_post(bigmpi_request_t * req)
+{
+    bigmpi_reduce_scatter_t * rs = req->state;
+    bigmpi_context_t * ctx = rs->ctx;
+    int size  = ctx->size;
+    int left  = ctx->ring[(ctx->ring_pos+size-1)%size];
+    int right = ctx->ring[(ctx->ring_pos+1)%size];
+
+    if (rs->step==0) {
+        /* This process starts the partial result of the block of its ring predecessor. */
+        const MPI_Count * displs = rs->counts+size;
+        rs->sendptr = rs->in+(displs[left]+rs->offset)*rs->extent;
+        rs->sendn   = BigMPI_Reduce_scatter_slice(rs, left);
+    }
+
+    int rb = BigMPI_Reduce_scatter_recv_block(rs);
+    int rc = MPI_Irecv(rs->tmp, BigMPI_Reduce_scatter_slice(rs, rb), rs->datatype,
+                       left, rs->tag, ctx->dup, &req->reqs[0]);
+    if (rc==MPI_SUCCESS) {
+        rc = MPI_Isend((void*)rs->sendptr, rs->sendn, rs->datatype,
+                       right, rs->tag, ctx->dup, &req->reqs[1]);
+    }
+    return rc;
+}
+
+/* Adds the own input to the partial result that has arrived and moves on. */
+static int BigMPI_Reduce_scatter_progress(bigmpi_request_t * req)
+{
+    bigmpi_reduce_scatter_t * rs = req->state;
+    int size = rs->ctx->size;
+    const MPI_Count * displs = rs->counts+size;
+
+    int rb = BigMPI_Reduce_scatter_recv_block(rs);
+    int rn = BigMPI_Reduce_scatter_slice(rs, rb);
+    if (rn > 0) {
+        MPIX_Reduce_local_x(rs->in+(displs[rb]+rs->offset)*rs->extent, rs->tmp, rn, rs->datatype, rs->op);
+    }
+    void * t    = rs->acc;
+    rs->acc     = rs->tmp;
+    rs->tmp     = t;
+    rs->sendptr = rs->acc;
+    rs->sendn   = rn;
+
+    if (++rs->step < size-1) {
+        BigMPI_Reduce_scatter_post(req);
+        return 0;
+    }
+
+    /* The last block to arrive is the own one.  All input below offset+chunk
+     * has been read by now, so this is safe in place. */
+    if (rn > 0) {
+        memcpy(rs->recvbuf+rs->offset*rs->extent, rs->acc, (size_t)rn*rs->extent);
+    }
+
+    rs->step    = 0;
+    rs->offset += rs->chunk;
+    if (rs->offset >= rs->maxcount) {
+        return 1;
+    }
+    BigMPI_Reduce_scatter_post(req);
+    return 0;
+}
+
+/*
+ * Synopsis
+ *
+ * int BigMPI_Reduce_scatter_ring(const void *sendbuf, void *recvbuf,
+ *                                const MPI_Count counts[], const MPI_Count displs[],
+ *                                MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+ *                                MPI_Request * request)
+ *
+ *  Input Parameters
+ *
+ *   counts             number of elements of the result of every process
+ *   displs             offset of the input block of every process (in elements)
+ *   request            NULL to complete the operation before returning
+ *   all others         as in MPI_Reduce_scatter
+ *
+ * Output Parameters
+ *
+ *   request            request that completes with the operation (unless NULL)
+ *
+ * Notes
+ *
+ *   Only commutative ops may be used.  A blocking reduce-scatter uses the scratch
+ *   buffer of the context and tag 0, a nonblocking one owns its scratch buffer
+ *   and uses a tag of its own on the private communicator.
+ *
+ */
+static int BigMPI_Reduce_scatter_ring(BIGMPI_CONST void *sendbuf, void *recvbuf,
+                                      const MPI_Count counts[], const MPI_Count displs[],
+                                      MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+                                      MPI_Request * request)
+{
+    bigmpi_context_t * ctx = BigMPI_Get_context(comm);
+    int size = ctx->size;
+
+    /* With MPI_IN_PLACE, the input is in recvbuf and the result goes to its beginning. */
+    const void * in = (sendbuf==MPI_IN_PLACE) ? recvbuf : sendbuf;
+
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(datatype, &lb, &extent);
+
+    MPI_Count maxcount = 0;
+    for (int b=0; b<size; b++) {
+        if (counts[b] > maxcount) maxcount = counts[b];
+    }
+
+    MPI_Count chunk = BigMPI_Get_pipeline_chunk()/extent;
+    if (chunk > maxcount)       chunk = maxcount;
+    if (chunk < 1)              chunk = 1;
+    if (chunk > bigmpi_int_max) chunk = bigmpi_int_max;
+
+    int rank = ctx->ring[ctx->ring_pos];
+    bigmpi_request_t * req = BigMPI_Request_create(size > 1 ? 2 : 0);
+
+    int rc = MPI_SUCCESS;
+    if (size==1) {
+        if (sendbuf!=MPI_IN_PLACE) {
+            memcpy(recvbuf, in+displs[rank]*extent, (size_t)counts[rank]*extent);
+        } else if (displs[rank]!=0) {
+            memmove(recvbuf, in+displs[rank]*extent, (size_t)counts[rank]*extent);
+        }
+    } else if (maxcount > 0) {
+        bigmpi_reduce_scatter_t * rs = malloc(sizeof(bigmpi_reduce_scatter_t)+2*size*sizeof(MPI_Count));
+        assert(rs!=NULL);
+        memcpy(rs->counts,      counts, size*sizeof(MPI_Count));
+        memcpy(rs->counts+size, displs, size*sizeof(MPI_Count));
+
+        void * scratch = NULL;
+        if (request==NULL) {
+            scratch = BigMPI_Get_scratch(ctx, 2*chunk*extent);
+            rs->tag = 0;
+        } else {
+            MPI_Alloc_mem(2*chunk*extent, MPI_INFO_NULL, &req->tempbuf);
+            assert(req->tempbuf!=NULL);
+            scratch = req->tempbuf;
+            rs->tag = BigMPI_Get_schedule_tag(ctx);
+        }
+
+        rs->ctx      = ctx;
+        rs->in       = in;
+        rs->recvbuf  = recvbuf;
+        rs->datatype = datatype;
+        rs->op       = op;
+        rs->extent   = extent;
+        rs->chunk    = chunk;
+        rs->maxcount = maxcount;
+        rs->offset   = 0;
+        rs->step     = 0;
+        rs->tmp      = scratch;
+        rs->acc      = scratch+chunk*extent;
+
+        req->state    = rs;
+        req->progress = BigMPI_Reduce_scatter_progress;
+        rc = BigMPI_Reduce_scatter_post(req);
+    }
+
+    if (request==NULL) {
+        BigMPI_Request_wait(req);
+    } else {
+        int rc2 = BigMPI_Request_start(req, request);
+        if (rc==MPI_SUCCESS) rc = rc2;
+    }
+    return rc;
+}
+
+/* MPI-3 Section 5.10
+ * Advice to implementers:
+ * The MPI_REDUCE_SCATTER_BLOCK routine is functionally equivalent to:
+ * an MPI_REDUCE collective operation with count equal to recvcount*n,
+ * followed by an MPI_SCATTER with sendcount equal to recvcount. */
+
+/* The previous statement is untrue when sendbuf=MPI_IN_PLACE so we
+ * are forced to buffer even in the in-place case.  This only matters
+ * for non-commutative ops now, which cannot be reduced around the ring. */
+
+/* BigMPI_Reduce_scatter_ring with recvcount elements for every process.  The schedule
+ * keeps its own copy of the counts, so they are freed right away. */
+static int BigMPI_Reduce_scatter_block_ring(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count recvcount,
+                                            MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+                                            MPI_Request * request)
+{
+    int commsize;
+    MPI_Comm_size(comm, &commsize);
+
+    MPI_Count * counts = malloc(2*commsize*sizeof(MPI_Count)); assert(counts!=NULL);
+    MPI_Count * displs = counts+commsize;
+    for (int i=0; i<commsize; i++) {
+        counts[i] = recvcount;
+        displs[i] = i*recvcount;
+    }
+    int rc = BigMPI_Reduce_scatter_ring(sendbuf, recvbuf, counts, displs, datatype, op, comm, request);
+    free(counts);
+    return rc;
+}
+
+int MPIX_Reduce_scatter_block_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count recvcount,
+                                MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+    if (likely (recvcount <= bigmpi_int_max )) {
+        return MPI_Reduce_scatter_block(sendbuf, recvbuf, (int)recvcount, datatype, op, comm);
+    } else {
+        int root = 0;
+
+        int commsize;
+        MPI_Comm_size(comm, &commsize);
+        MPI_Count sendcount = recvcount * commsize;
+
+        int commute;
+        MPI_Op_commutative(op, &commute);
+        if (commute) {
+            return BigMPI_Reduce_scatter_block_ring(sendbuf, recvbuf, recvcount, datatype, op, comm, NULL);
+        }
+
+        MPI_Aint lb /* unused */, extent;
+        MPI_Type_get_extent(datatype, &lb, &extent);
+        MPI_Aint buf_size = (MPI_Aint)sendcount * extent;
+
+        void * tempbuf = NULL;
+        MPI_Alloc_mem(buf_size, MPI_INFO_NULL, &tempbuf);
+        assert(tempbuf!=NULL);
+
+        MPIX_Reduce_x(sendbuf==MPI_IN_PLACE ? recvbuf : sendbuf,
+                      tempbuf, sendcount, datatype, op, root, comm);
+        MPIX_Scatter_x(tempbuf, recvcount, datatype, recvbuf, recvcount, datatype, root, comm);
+
+        MPI_Free_mem(tempbuf);
+    }
+    return MPI_SUCCESS;
+}
+
+/* The input of a reduce-scatter is the concatenation of the blocks of all processes. */
+static MPI_Count BigMPI_Reduce_scatter_sendcount(int size, const MPI_Count recvcounts[])
+{
+    MPI_Count sendcount = 0;
+    for (int i=0; i<size; i++) {
+        sendcount += recvcounts[i];
+    }
+    return sendcount;
+}
+
+/* Unless every block fits into an int (as does its offset, which MPI computes itself),
+ * this is a reduce-scatter around the ring for commutative ops and MPI-3 Section 5.10
+ * (see above) for the others. */
+
+int MPIX_Reduce_scatter_x(BIGMPI_CONST void *sendbuf, void *recvbuf, const MPI_Count recvcounts[],
+                          MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+    int commsize;
+    MPI_Comm_size(comm, &commsize);
+    MPI_Count sendcount = BigMPI_Reduce_scatter_sendcount(commsize, recvcounts);
+
+    int rc = MPI_SUCCESS;
+    if (likely (sendcount <= bigmpi_int_max )) {
+        int * icounts = malloc(commsize*sizeof(int)); assert(icounts!=NULL);
+        for (int i=0; i<commsize; i++) {
+            icounts[i] = (int)recvcounts[i];
+        }
+        rc = MPI_Reduce_scatter(sendbuf, recvbuf, icounts, datatype, op, comm);
+        free(icounts);
+        return rc;
+    }
+
+    int commute;
+    MPI_Op_commutative(op, &commute);
+    if (commute) {
+        MPI_Count * displs = malloc(commsize*sizeof(MPI_Count)); assert(displs!=NULL);
+        displs[0] = 0;
+        for (int i=1; i<commsize; i++) {
+            displs[i] = displs[i-1]+recvcounts[i-1];
+        }
+        rc = BigMPI_Reduce_scatter_ring(sendbuf, recvbuf, recvcounts, displs, datatype, op, comm, NULL);
+        free(displs);
+    } else {
+        int root = 0;
+        int commrank;
+        MPI_Comm_rank(comm, &commrank);
+
+        MPI_Aint * displs = malloc(commsize*sizeof(MPI_Aint)); assert(displs!=NULL);
+        displs[0] = 0;
+        for (int i=1; i<commsize; i++) {
+            displs[i] = displs[i-1]+(MPI_Aint)recvcounts[i-1];
+        }
+
+        MPI_Aint lb /* unused */, extent;
+        MPI_Type_get_extent(datatype, &lb, &extent);
+
+        /* Only the root needs the whole result. */
+        void * tempbuf = NULL;
+        if (commrank==root) {
+            MPI_Alloc_mem((MPI_Aint)sendcount * extent, MPI_INFO_NULL, &tempbuf);
+            assert(tempbuf!=NULL);
+        }
+
+        rc = MPIX_Reduce_x(sendbuf==MPI_IN_PLACE ? recvbuf : sendbuf,
+                           tempbuf, sendcount, datatype, op, root, comm);
+        if (rc==MPI_SUCCESS) {
+            rc = MPIX_Scatterv_x(tempbuf, recvcounts, displs, datatype,
+                                 recvbuf, recvcounts[commrank], datatype, root, comm);
+        }
+
+        if (tempbuf!=NULL) {
+            MPI_Free_mem(tempbuf);
+        }
+        free(displs);
+    }
+    return rc;
+}
+
+/* MPI_Scan and MPI_Exscan work elementwise, so they are always cleaved into native scans
+ * of at most BIGMPI_PIPELINE_CHUNK bytes, whether or not the other reductions are, which
+ * works for every op and spares the big op a pass over the whole vector at once. */
+
+int MPIX_Scan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+    if (likely (count <= bigmpi_int_max )) {
+        return MPI_Scan(sendbuf, recvbuf, (int)count, datatype, op, comm);
+    } else {
+        return BigMPI_Reduce_cleaved(BIGMPI_SCAN, sendbuf, recvbuf, count, datatype, op, MPI_PROC_NULL, comm);
+    }
+}
+
+int MPIX_Exscan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+    if (likely (count <= bigmpi_int_max )) {
+        return MPI_Exscan(sendbuf, recvbuf, (int)count, datatype, op, comm);
+    } else {
+        return BigMPI_Reduce_cleaved(BIGMPI_EXSCAN, sendbuf, recvbuf, count, datatype, op, MPI_PROC_NULL, comm);
+    }
+}
+
+/* A streaming allreduce reduces every slice that is pushed with native allreduces of at
+ * most BIGMPI_PIPELINE_CHUNK bytes, BIGMPI_PIPELINE_DEPTH of which are in flight (one
+ * without MPI-3, where they are blocking), like BigMPI_Reduce_cleaved does. */
+struct bigmpi_allreduce_stream_s {
+    const void * sendbuf;
+    void       * recvbuf;
+    MPI_Count    count;
+    MPI_Count    pushed;   /* elements pushed so far */
+    MPI_Datatype datatype;
+    MPI_Aint     extent;
+    MPI_Op       op;
+    MPI_Comm     comm;
+    MPI_Count    chunk;
+    int          depth;
+    int          next;     /* slot of reqs for the next native allreduce */
+    MPI_Request  reqs[];
+};
+
+/*
+ * Synopsis
+ *
+ * int MPIX_Allreduce_stream_begin_x(const void *sendbuf, void *recvbuf, MPI_Count count,
+ *                                   MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+ *                                   MPIX_Allreduce_stream *stream)
+ *
+ *  Input Parameters
+ *
+ *   all                as in MPI_Allreduce
+ *
+ * Output Parameters
+ *
+ *   stream             handle for MPIX_Allreduce_stream_push_x and MPIX_Allreduce_stream_end_x
+ *
+ * Notes
+ *
+ *   Local.  Nothing is communicated until slices are pushed.
+ *
+ */
+int MPIX_Allreduce_stream_begin_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+                                  MPIX_Allreduce_stream *stream)
+{
+    int depth = 1;
+#if MPI_VERSION >= 3
+    depth = BigMPI_Get_pipeline_depth();
+#endif
+
+    struct bigmpi_allreduce_stream_s * s = malloc(sizeof(struct bigmpi_allreduce_stream_s)+depth*sizeof(MPI_Request));
+    assert(s!=NULL);
+
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(datatype, &lb, &extent);
+
+    MPI_Count chunk = BigMPI_Get_pipeline_chunk()/extent;
+    if (chunk < 1) chunk = 1;
+    if (chunk > bigmpi_int_max) chunk = bigmpi_int_max;
+
+    s->sendbuf  = sendbuf;
+    s->recvbuf  = recvbuf;
+    s->count    = count;
+    s->pushed   = 0;
+    s->datatype = datatype;
+    s->extent   = extent;
+    s->op       = op;
+    s->comm     = comm;
+    s->chunk    = chunk;
+    s->depth    = depth;
+    s->next     = 0;
+    for (int i=0; i<depth; i++) {
+        s->reqs[i] = MPI_REQUEST_NULL;
+    }
+
+    *stream = s;
+    return MPI_SUCCESS;
+}
+
+/*
+ * Synopsis
+ *
+ * int MPIX_Allreduce_stream_push_x(MPIX_Allreduce_stream stream, MPI_Count offset, MPI_Count count)
+ *
+ *  Input Parameters
+ *
+ *   stream             stream returned by MPIX_Allreduce_stream_begin_x
+ *   offset             first element of the slice
+ *   count              number of elements of the slice
+ *
+ * Notes
+ *
+ *   Starts the reduction of the slice, whose input (in sendbuf or, with
+ *   MPI_IN_PLACE, in recvbuf) must not change anymore.  Collective: all
+ *   processes have to push the same slices in the same order, and the slices
+ *   have to cover the vector exactly once.  This only blocks while
+ *   BIGMPI_PIPELINE_DEPTH native allreduces are still in flight.
+ *
+ */
+int MPIX_Allreduce_stream_push_x(MPIX_Allreduce_stream stream, MPI_Count offset, MPI_Count count)
+{
+    struct bigmpi_allreduce_stream_s * s = stream;
+
+    if (offset < 0 || count < 0 || offset+count > s->count) {
+        BigMPI_Error("The slice [%lld,%lld) is not part of the vector of %lld elements. \n",
+                     (long long)offset, (long long)(offset+count), (long long)s->count);
+    }
+
+    int rc = MPI_SUCCESS;
+    for (MPI_Count i=offset; i<offset+count && rc==MPI_SUCCESS; i+=s->chunk) {
+        int n = (int)(offset+count-i < s->chunk ? offset+count-i : s->chunk);
+        MPI_Request * req = &s->reqs[s->next];
+        s->next = (s->next+1)%s->depth;
+        rc = MPI_Wait(req, MPI_STATUS_IGNORE);
+        if (rc!=MPI_SUCCESS) break;
+        rc = BigMPI_Reduction_native(BIGMPI_ALLREDUCE,
+                                     BigMPI_Reduction_input(BIGMPI_ALLREDUCE, s->sendbuf, s->recvbuf, i, s->extent, 0),
+                                     s->recvbuf+i*s->extent, n, s->datatype, s->op, MPI_PROC_NULL, s->comm, req);
+    }
+    s->pushed += count;
+
+    /* Give MPI a chance to progress the slices in flight while the next one is produced. */
+    if (rc==MPI_SUCCESS) {
+        int flag;
+        rc = MPI_Testall(s->depth, s->reqs, &flag, MPI_STATUSES_IGNORE);
+    }
+
+    return rc;
+}
+
+/*
+ * Synopsis
+ *
+ * int MPIX_Allreduce_stream_end_x(MPIX_Allreduce_stream *stream)
+ *
+ *  Input Parameters
+ *
+ *   stream             stream returned by MPIX_Allreduce_stream_begin_x
+ *
+ * Output Parameters
+ *
+ *   stream             NULL
+ *
+ * Notes
+ *
+ *   Completes the reduction of all slices, after which recvbuf holds the
+ *   result.  Collective.
+ *
+ */
+int MPIX_Allreduce_stream_end_x(MPIX_Allreduce_stream *stream)
+{
+    struct bigmpi_allreduce_stream_s * s = *stream;
+
+    int rc = MPI_Waitall(s->depth, s->reqs, MPI_STATUSES_IGNORE);
+
+    if (s->pushed!=s->count) {
+        BigMPI_Error("%lld of %lld elements were pushed to the allreduce stream. \n",
+                     (long long)s->pushed, (long long)s->count);
+    }
+
+    free(s);
+    *stream = NULL;
+
+    return rc;
+}
+
+#if MPI_VERSION >= 3
+
+/* With asynchronous progress, large nonblocking reductions are cleaved like the
+ * blocking ones, which handles MPI_IN_PLACE without any temporaries.  Otherwise,
+ * they are a single native reduction of a large-count type with a big op.  MPI
+ * keeps the type alive until the operation completes, the big op is cached, and
+ * MPI takes care of in-place. */
+
+int MPIX_Ireduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                   MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm, MPI_Request * req)
+{
+    if (likely (count <= bigmpi_int_max )) {
+        return MPI_Ireduce(sendbuf, recvbuf, (int)count, datatype, op, root, comm, req);
+    } else if (BigMPI_Async_progress()) {
+        return BigMPI_Ireduce_cleaved(BIGMPI_REDUCE, sendbuf, recvbuf, count, datatype, op, root, comm, req);
+    } else {
+
+        MPI_Datatype bigtype;
+        BigMPI_Type_contiguous(0,count, datatype, &bigtype);
+        MPI_Type_commit(&bigtype);
+
+        MPI_Op bigop = BigMPI_Op_get_cached(op);
+
+        /* Non-roots may pass MPI_IN_PLACE, too, in which case their input is in recvbuf. */
+        if (sendbuf==MPI_IN_PLACE) {
+            int commrank;
+            MPI_Comm_rank(comm, &commrank);
+            if (commrank!=root) {
+                sendbuf = recvbuf;
+            }
+        }
+
+        int rc = MPI_Ireduce(sendbuf, recvbuf, 1, bigtype, bigop, root, comm, req);
+
+        MPI_Type_free(&bigtype);
+
+        return rc;
+
+    }
+}
+
+int MPIX_Iallreduce_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                     MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request * req)
+{
+    if (likely (count <= bigmpi_int_max )) {
+        return MPI_Iallreduce(sendbuf, recvbuf, (int)count, datatype, op, comm, req);
+    } else if (BigMPI_Async_progress()) {
+        return BigMPI_Ireduce_cleaved(BIGMPI_ALLREDUCE, sendbuf, recvbuf, count, datatype, op,
+                                      MPI_PROC_NULL, comm, req);
+    } else {
+
+        MPI_Datatype bigtype;
+        BigMPI_Type_contiguous(0,count, datatype, &bigtype);
+        MPI_Type_commit(&bigtype);
+
+        MPI_Op bigop = BigMPI_Op_get_cached(op);
+
+        int rc = MPI_Iallreduce(sendbuf, recvbuf, 1, bigtype, bigop, comm, req);
+
+        MPI_Type_free(&bigtype);
+
+        return rc;
+
+    }
+}
+
+/* With asynchronous progress and a commutative op, large blocks are reduced around the ring
+ * by a schedule that owns its scratch buffer (see BigMPI_Reduce_scatter_ring), so nothing
+ * has to outlive the call but the buffers.  Otherwise, this is a single native reduce-scatter
+ * of a large-count type with a big op, which is cached, so it outlives the request. */
+int MPIX_Ireduce_scatter_block_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count recvcount,
+                                 MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request)
+{
+    int commute;
+    MPI_Op_commutative(op, &commute);
+
+    if (likely (recvcount <= bigmpi_int_max )) {
+        return MPI_Ireduce_scatter_block(sendbuf, recvbuf, (int)recvcount, datatype, op, comm, request);
+    } else if (!BigMPI_Async_progress() || !commute) {
+
+        MPI_Datatype bigtype;
+        BigMPI_Type_contiguous(0,recvcount, datatype, &bigtype);
+        MPI_Type_commit(&bigtype);
+
+        MPI_Op bigop = BigMPI_Op_get_cached(op);
+
+        int rc = MPI_Ireduce_scatter_block(sendbuf, recvbuf, 1, bigtype, bigop, comm, request);
+
+        MPI_Type_free(&bigtype);
+
+        return rc;
+
+    }
+
+    return BigMPI_Reduce_scatter_block_ring(sendbuf, recvbuf, recvcount, datatype, op, comm, request);
+}
+
+/* What a native reduce-scatter of units (see BigMPI_Ireduce_scatter_units) needs until it completes. */
+typedef struct {
+    int    * icounts;
+    void   * sendtmp;   /* padded input, NULL if the blocks are not padded */
+    void   * recvtmp;   /* padded result of this process */
+    void   * recvbuf;
+    size_t   bytes;     /* of the result of this process */
+} bigmpi_reduce_scatter_units_t;
+
+static void BigMPI_Reduce_scatter_units_complete(void * state)
+{
+    bigmpi_reduce_scatter_units_t * s = state;
+    if (s->recvtmp!=NULL) {
+        memcpy(s->recvbuf, s->recvtmp, s->bytes);
+    }
+    free(s->sendtmp);
+    free(s->recvtmp);
+    free(s->icounts);
+    free(s);
+}
+
+/* A reduce-scatter as a single native MPI_Ireduce_scatter with the big op of op, for
+ * when BigMPI cannot complete a request of its own (see progress.c) or op does not
+ * commute.  The blocks are counted in units of a large-count type of the greatest
+ * common divisor of recvcounts elements, so no copies are needed unless there are more
+ * than INT_MAX of those in a block.  Then the units are just large enough and every
+ * block is padded to whole units in temporary buffers, out of which the result is
+ * copied when the reduce-scatter completes.  The temporary buffers and the int counts
+ * are freed then, too (see BigMPI_Type_free_on_completion). */
+static int BigMPI_Ireduce_scatter_units(BIGMPI_CONST void *sendbuf, void *recvbuf, const MPI_Count recvcounts[],
+                                        MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request)
+{
+    int commsize, commrank;
+    MPI_Comm_size(comm, &commsize);
+    MPI_Comm_rank(comm, &commrank);
+
+    MPI_Count maxcount = 0, unit = 0;
+    for (int i=0; i<commsize; i++) {
+        if (recvcounts[i] > maxcount) maxcount = recvcounts[i];
+        MPI_Count a = unit, b = recvcounts[i];
+        while (b!=0) {
+            MPI_Count t = a%b;
+            a = b;
+            b = t;
+        }
+        unit = a;
+    }
+    if (unit==0) unit = 1;
+
+    int padded = (maxcount/unit > bigmpi_int_max);
+    if (padded) {
+        unit = maxcount/bigmpi_int_max+1;
+    }
+
+    bigmpi_reduce_scatter_units_t * s = malloc(sizeof(bigmpi_reduce_scatter_units_t)); assert(s!=NULL);
+    s->icounts = malloc(commsize*sizeof(int)); assert(s->icounts!=NULL);
+    s->sendtmp = NULL;
+    s->recvtmp = NULL;
+    s->recvbuf = recvbuf;
+
+    MPI_Count units = 0;
+    for (int i=0; i<commsize; i++) {
+        s->icounts[i] = (int)((recvcounts[i]+unit-1)/unit);
+        units += s->icounts[i];
+    }
+
+    MPI_Aint lb /* unused */, extent;
+    MPI_Type_get_extent(datatype, &lb, &extent);
+    s->bytes = (size_t)recvcounts[commrank]*extent;
+
+    if (padded) {
+        /* With MPI_IN_PLACE, the input is in recvbuf. */
+        const void * in = (sendbuf==MPI_IN_PLACE) ? recvbuf : sendbuf;
+        s->sendtmp = malloc((size_t)units*unit*extent); assert(s->sendtmp!=NULL);
+        s->recvtmp = malloc((size_t)s->icounts[commrank]*unit*extent); assert(s->recvtmp!=NULL);
+        MPI_Count offset = 0, poffset = 0;
+        for (int i=0; i<commsize; i++) {
+            MPI_Count padding = (MPI_Count)s->icounts[i]*unit-recvcounts[i];
+            memcpy(s->sendtmp+poffset*extent, in+offset*extent, (size_t)recvcounts[i]*extent);
+            memset(s->sendtmp+(poffset+recvcounts[i])*extent, 0, (size_t)padding*extent);
+            offset  += recvcounts[i];
+            poffset += (MPI_Count)s->icounts[i]*unit;
+        }
+    }
+
+    MPI_Datatype unittype;
+    BigMPI_Type_contiguous(0,unit, datatype, &unittype);
+    MPI_Type_commit(&unittype);
+
+    MPI_Op bigop = BigMPI_Op_get_cached(op);
+
+    int rc = MPI_Ireduce_scatter(padded ? s->sendtmp : sendbuf, padded ? s->recvtmp : recvbuf,
+                                 s->icounts, unittype, bigop, comm, request);
+    if (rc!=MPI_SUCCESS) {
+        MPI_Type_free(&unittype);
+        free(s->sendtmp);
+        free(s->recvtmp);
+        free(s->icounts);
+        free(s);
+        return rc;
+    }
+
+    return BigMPI_Type_free_on_completion(&unittype, request, BigMPI_Reduce_scatter_units_complete, s);
+}
+
+int MPIX_Ireduce_scatter_x(BIGMPI_CONST void *sendbuf, void *recvbuf, const MPI_Count recvcounts[],
+                           MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request)
+{
+    int commsize;
+    MPI_Comm_size(comm, &commsize);
+    MPI_Count sendcount = BigMPI_Reduce_scatter_sendcount(commsize, recvcounts);
+
+    if (likely (sendcount <= bigmpi_int_max )) {
+        int equal = 1;
+        for (int i=1; i<commsize; i++) {
+            equal = equal && (recvcounts[i]==recvcounts[0]);
+        }
+        if (equal) {
+            return MPI_Ireduce_scatter_block(sendbuf, recvbuf, (int)recvcounts[0], datatype, op, comm, request);
+        }
+        if (BigMPI_Op_has_bigop(op)) {
+            return BigMPI_Ireduce_scatter_units(sendbuf, recvbuf, recvcounts, datatype, op, comm, request);
+        }
+
+        /* The unit type tells BigMPI when the int counts may be freed, but only ops with a
+         * big op can reduce it, so the communicator owns the counts of other ops. */
+        const int * icounts = BigMPI_Get_int_counts(comm, recvcounts);
+        return MPI_Ireduce_scatter(sendbuf, recvbuf, (int*)icounts, datatype, op, comm, request);
+    }
+
+    int commute;
+    MPI_Op_commutative(op, &commute);
+    if (!BigMPI_Async_progress() || !commute) {
+        return BigMPI_Ireduce_scatter_units(sendbuf, recvbuf, recvcounts, datatype, op, comm, request);
+    }
+
+    MPI_Count * displs = malloc(commsize*sizeof(MPI_Count)); assert(displs!=NULL);
+    displs[0] = 0;
+    for (int i=1; i<commsize; i++) {
+        displs[i] = displs[i-1]+recvcounts[i-1];
+    }
+    int rc = BigMPI_Reduce_scatter_ring(sendbuf, recvbuf, recvcounts, displs, datatype, op, comm, request);
+    free(displs);
+    return rc;
+}
+
+/* With asynchronous progress, these are cleaved like MPIX_Scan_x.  Without it, several
+ * native scans cannot be handed to the user as one request, so these are a single
+ * native scan of a large-count type with a big op, which reduces the whole vector in
+ * one call instead of overlapping the chunks.  MPI keeps the type alive until the
+ * scan completes and the big op is cached, so both outlive the request. */
+
+int MPIX_Iscan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                 MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request)
+{
+    if (likely (count <= bigmpi_int_max )) {
+        return MPI_Iscan(sendbuf, recvbuf, (int)count, datatype, op, comm, request);
+    } else if (BigMPI_Async_progress()) {
+        return BigMPI_Ireduce_cleaved(BIGMPI_SCAN, sendbuf, recvbuf, count, datatype, op,
+                                      MPI_PROC_NULL, comm, request);
+    } else {
+        MPI_Datatype bigtype;
+        BigMPI_Type_contiguous(0,count, datatype, &bigtype);
+        MPI_Type_commit(&bigtype);
+        MPI_Op bigop = BigMPI_Op_get_cached(op);
+        int rc = MPI_Iscan(sendbuf, recvbuf, 1, bigtype, bigop, comm, request);
+        MPI_Type_free(&bigtype);
+        return rc;
+    }
+}
+
+int MPIX_Iexscan_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                   MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request)
+{
+    if (likely (count <= bigmpi_int_max )) {
+        return MPI_Iexscan(sendbuf, recvbuf, (int)count, datatype, op, comm, request);
+    } else if (BigMPI_Async_progress()) {
+        return BigMPI_Ireduce_cleaved(BIGMPI_EXSCAN, sendbuf, recvbuf, count, datatype, op,
+                                      MPI_PROC_NULL, comm, request);
+    } else {
+        MPI_Datatype bigtype;
+        BigMPI_Type_contiguous(0,count, datatype, &bigtype);
+        MPI_Type_commit(&bigtype);
+        MPI_Op bigop = BigMPI_Op_get_cached(op);
+        int rc = MPI_Iexscan(sendbuf, recvbuf, 1, bigtype, bigop, comm, request);
+        MPI_Type_free(&bigtype);
+        return rc;
+    }
+}
+
+#endif
+
+#ifdef BIGMPI_HAVE_PERSISTENT_COLLECTIVES
+
+/* Unlike MPIX_Allreduce_x, this always reduces a single element of a large-count
+ * type with a big op, because a persistent request cannot be cleaved into several. */
+int MPIX_Allreduce_init_x(BIGMPI_CONST void *sendbuf, void *recvbuf, MPI_Count count,
+                          MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Info info, MPI_Request *request)
+{
+    if (likely (count <= bigmpi_int_max )) {
+        return BIGMPI_PCOLL(Allreduce_init)(sendbuf, recvbuf, (int)count, datatype, op, comm, info, request);
+    } else {
+
+        MPI_Datatype bigtype = BigMPI_Type_contiguous_cached(count, datatype);
+        MPI_Op bigop = BigMPI_Op_get_cached(op);
+
+        return BIGMPI_PCOLL(Allreduce_init)(sendbuf, recvbuf, 1, bigtype, bigop, comm, info, request);
 
     }
 }
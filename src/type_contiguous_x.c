@@ -1,4 +1,5 @@
 #include "bigmpi_impl.h"
+#include <pthread.h>
 
 /* This function does all the heavy lifting in BigMPI. */
 
@@ -232,3 +233,90 @@ int MPIX_Type_contiguous_x(MPI_Count count, MPI_Datatype oldtype, MPI_Datatype *
 {
     return BigMPI_Type_contiguous(0, count, oldtype, newtype);
 }
+
+#ifdef BIGMPI_HAVE_PERSISTENT_COLLECTIVES
+
+/* Persistent operations need their large-count types for as long as the user
+ * keeps the request, which BigMPI does not learn about, so those types are
+ * cached (one per count and oldtype) and only freed at MPI_Finalize.  Not every
+ * MPI library keeps the datatypes of persistent requests alive (the pcollreq
+ * extension of Open MPI 4 does not), so no type may be freed any earlier.
+ * Other operations create and free their types themselves. */
+
+typedef struct bigmpi_type_cache_s {
+    MPI_Count                    count;
+    MPI_Datatype                 oldtype;
+    MPI_Datatype                 newtype;
+    struct bigmpi_type_cache_s * next;
+} bigmpi_type_cache_t;
+
+static pthread_mutex_t       BigMPI_type_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static bigmpi_type_cache_t * BigMPI_type_cache = NULL;   /* most recently used first */
+
+static void BigMPI_Type_cache_finalize(void)
+{
+    pthread_mutex_lock(&BigMPI_type_cache_lock);
+    while (BigMPI_type_cache!=NULL) {
+        bigmpi_type_cache_t * entry = BigMPI_type_cache;
+        BigMPI_type_cache = entry->next;
+        MPI_Type_free(&entry->newtype);
+        free(entry);
+    }
+    pthread_mutex_unlock(&BigMPI_type_cache_lock);
+}
+
+/*
+ * Synopsis
+ *
+ * MPI_Datatype BigMPI_Type_contiguous_cached(MPI_Count count, MPI_Datatype oldtype)
+ *
+ *  Input Parameters
+ *
+ *   count              replication count
+ *   oldtype            old datatype
+ *
+ * Output Parameters
+ *
+ *   newtype            committed BigMPI_Type_contiguous type, owned by BigMPI
+ *
+ * Notes
+ *
+ *   Only for persistent operations, whose requests may outlive any type that
+ *   BigMPI frees right after starting the operation.
+ *
+ */
+MPI_Datatype BigMPI_Type_contiguous_cached(MPI_Count count, MPI_Datatype oldtype)
+{
+    MPI_Datatype newtype = MPI_DATATYPE_NULL;
+
+    pthread_mutex_lock(&BigMPI_type_cache_lock);
+    for (bigmpi_type_cache_t ** prev = &BigMPI_type_cache; *prev!=NULL; prev = &(*prev)->next) {
+        bigmpi_type_cache_t * entry = *prev;
+        if (entry->count==count && entry->oldtype==oldtype) {
+            newtype = entry->newtype;
+            /* Move it to the front. */
+            *prev = entry->next;
+            entry->next = BigMPI_type_cache;
+            BigMPI_type_cache = entry;
+            break;
+        }
+    }
+    if (newtype==MPI_DATATYPE_NULL) {
+        BigMPI_Type_contiguous(0,count, oldtype, &newtype);
+        MPI_Type_commit(&newtype);
+        if (BigMPI_type_cache==NULL) {
+            BigMPI_Atfinalize(BigMPI_Type_cache_finalize);
+        }
+        bigmpi_type_cache_t * entry = malloc(sizeof(bigmpi_type_cache_t)); assert(entry!=NULL);
+        entry->count   = count;
+        entry->oldtype = oldtype;
+        entry->newtype = newtype;
+        entry->next    = BigMPI_type_cache;
+        BigMPI_type_cache = entry;
+    }
+    pthread_mutex_unlock(&BigMPI_type_cache_lock);
+
+    return newtype;
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "bigmpi_impl.h"
+#include <pthread.h>
 
 /* This is a workaround for tests so that BIGMPI_MAX_INT is visible without header inclusion. */
 MPI_Count BigMPI_Get_max_int(void)
@@ -37,6 +38,48 @@ void BigMPI_Error_impl(const char *file, const int line, const char *func, const
     MPI_Abort(MPI_COMM_WORLD, 100);
 }
 
+/* Cleanup functions registered with BigMPI_Atfinalize run (last in, first out)
+ * when MPI deletes the attributes of MPI_COMM_SELF, which MPI-3 guarantees to
+ * happen at the beginning of MPI_Finalize, while MPI is still fully usable. */
+
+#define BIGMPI_MAX_ATFINALIZE 16
+
+static pthread_mutex_t BigMPI_atfinalize_lock = PTHREAD_MUTEX_INITIALIZER;
+static void (*BigMPI_atfinalize_fns[BIGMPI_MAX_ATFINALIZE])(void);
+static int BigMPI_atfinalize_count = 0;
+static int BigMPI_atfinalize_keyval = MPI_KEYVAL_INVALID;
+
+static int BigMPI_Atfinalize_delete(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state)
+{
+    pthread_mutex_lock(&BigMPI_atfinalize_lock);
+    for (int i=BigMPI_atfinalize_count-1; i>=0; i--) {
+        BigMPI_atfinalize_fns[i]();
+    }
+    BigMPI_atfinalize_count = 0;
+    pthread_mutex_unlock(&BigMPI_atfinalize_lock);
+
+    MPI_Comm_free_keyval(&BigMPI_atfinalize_keyval);
+    return MPI_SUCCESS;
+}
+
+/* Register a function that releases BigMPI state at MPI_Finalize.
+ *
+ * @param[in] fn   Cleanup function
+ */
+void BigMPI_Atfinalize(void (*fn)(void))
+{
+    pthread_mutex_lock(&BigMPI_atfinalize_lock);
+    if (BigMPI_atfinalize_count==0) {
+        MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, BigMPI_Atfinalize_delete, &BigMPI_atfinalize_keyval, NULL);
+        MPI_Comm_set_attr(MPI_COMM_SELF, BigMPI_atfinalize_keyval, NULL);
+    }
+    if (BigMPI_atfinalize_count==BIGMPI_MAX_ATFINALIZE) {
+        BigMPI_Error("Too many cleanup functions registered. \n");
+    }
+    BigMPI_atfinalize_fns[BigMPI_atfinalize_count++] = fn;
+    pthread_mutex_unlock(&BigMPI_atfinalize_lock);
+}
+
 /*
  * Synopsis
  *
@@ -57,6 +57,95 @@ bigmpi_method_t BigMPI_Get_default_vcollectives_method()
     return BigMPI_vcollectives_method;
 }
 
+/* Returns non-zero if the first num entries of counts and displs fit into int. */
+static int BigMPI_Vectors_fit_int(int num, const MPI_Count counts[], const MPI_Aint displs[])
+{
+    for (int i=0; i<num; i++) {
+        if (counts[i] > bigmpi_int_max || displs[i] > bigmpi_int_max || displs[i] < -bigmpi_int_max) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void BigMPI_Vectors_to_int(int num, const MPI_Count counts[], const MPI_Aint displs[],
+                                  int newcounts[], int newdispls[])
+{
+    for (int i=0; i<num; i++) {
+        newcounts[i] = (int)counts[i];
+        newdispls[i] = (int)displs[i];
+    }
+}
+
+/* Calls the MPI v-collective directly.  Only valid if every count and
+ * displacement that any process passes fits into int. */
+static int BigMPI_Collective_native(bigmpi_collective_t coll,
+                                    BIGMPI_CONST void *sendbuf,
+                                    const MPI_Count sendcount, const MPI_Count sendcounts[],
+                                    const MPI_Aint senddispls[],
+                                    const MPI_Datatype sendtype, const MPI_Datatype sendtypes[],
+                                    void *recvbuf,
+                                    const MPI_Count recvcount, const MPI_Count recvcounts[],
+                                    const MPI_Aint recvdispls[],
+                                    const MPI_Datatype recvtype, const MPI_Datatype recvtypes[],
+                                    int root,
+                                    MPI_Comm comm)
+{
+    int rc = MPI_SUCCESS;
+
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+
+    int * newsendcounts = NULL, * newsdispls = NULL;
+    int * newrecvcounts = NULL, * newrdispls = NULL;
+
+    if (sendcounts!=NULL) {
+        newsendcounts = malloc(size*sizeof(int)); assert(newsendcounts!=NULL);
+        newsdispls    = malloc(size*sizeof(int)); assert(newsdispls!=NULL);
+        BigMPI_Vectors_to_int(size, sendcounts, senddispls, newsendcounts, newsdispls);
+    }
+    if (recvcounts!=NULL) {
+        newrecvcounts = malloc(size*sizeof(int)); assert(newrecvcounts!=NULL);
+        newrdispls    = malloc(size*sizeof(int)); assert(newrdispls!=NULL);
+        BigMPI_Vectors_to_int(size, recvcounts, recvdispls, newrecvcounts, newrdispls);
+    }
+
+    switch(coll) {
+        case ALLTOALLW:
+            /* MPI_Alltoallw does not take const types in MPI-2. */
+            rc = MPI_Alltoallw(sendbuf, newsendcounts, newsdispls, (MPI_Datatype *)sendtypes,
+                               recvbuf, newrecvcounts, newrdispls, (MPI_Datatype *)recvtypes, comm);
+            break;
+        case ALLTOALLV:
+            rc = MPI_Alltoallv(sendbuf, newsendcounts, newsdispls, sendtype,
+                               recvbuf, newrecvcounts, newrdispls, recvtype, comm);
+            break;
+        case ALLGATHERV:
+            rc = MPI_Allgatherv(sendbuf, (int)sendcount, sendtype,
+                                recvbuf, newrecvcounts, newrdispls, recvtype, comm);
+            break;
+        case GATHERV:
+            rc = MPI_Gatherv(sendbuf, (int)sendcount, sendtype,
+                             recvbuf, newrecvcounts, newrdispls, recvtype, root, comm);
+            break;
+        case SCATTERV:
+            rc = MPI_Scatterv(sendbuf, newsendcounts, newsdispls, sendtype,
+                              recvbuf, (int)recvcount, recvtype, root, comm);
+            break;
+        default:
+            BigMPI_Error("Invalid collective chosen. \n");
+            break;
+    }
+
+    free(newsendcounts);
+    free(newsdispls);
+    free(newrecvcounts);
+    free(newrdispls);
+
+    return rc;
+}
+
 int BigMPI_Collective(bigmpi_collective_t coll, bigmpi_method_t method,
                       BIGMPI_CONST void *sendbuf,
                       const MPI_Count sendcount, const MPI_Count sendcounts[],
@@ -76,15 +165,47 @@ int BigMPI_Collective(bigmpi_collective_t coll, bigmpi_method_t method,
     if (is_intercomm)
         BigMPI_Error("BigMPI does not support intercommunicators yet.\n");
 
-    if (sendbuf==MPI_IN_PLACE)
-        BigMPI_Error("BigMPI does not support in-place in the v-collectives.  Sorry. \n");
-
     int size, rank;
     MPI_Comm_size(comm, &size);
     MPI_Comm_rank(comm, &rank);
 
+    /* Most v-collectives do not need large counts at all, in which case the
+     * MPI implementation's own algorithms are the best choice.  The vectors
+     * are only significant at some processes (e.g. the root of a gatherv),
+     * so all processes have to agree on the outcome of the local scan. */
+    {
+        /* Scatterv sends and gatherv receives vectors only at the root. */
+        const MPI_Count * scounts = (coll==SCATTERV && rank!=root) ? NULL : sendcounts;
+        const MPI_Count * rcounts = (coll==GATHERV  && rank!=root) ? NULL : recvcounts;
+
+        int fits = 1;
+        if (scounts!=NULL) {
+            fits = fits && BigMPI_Vectors_fit_int(size, scounts, senddispls);
+        } else if (sendbuf!=MPI_IN_PLACE) {
+            fits = fits && (sendcount <= bigmpi_int_max);
+        }
+        if (rcounts!=NULL) {
+            fits = fits && BigMPI_Vectors_fit_int(size, rcounts, recvdispls);
+        } else if (recvbuf!=MPI_IN_PLACE) {
+            fits = fits && (recvcount <= bigmpi_int_max);
+        }
+        MPI_Allreduce(MPI_IN_PLACE, &fits, 1, MPI_INT, MPI_LAND, comm);
+        if (likely(fits)) {
+            return BigMPI_Collective_native(coll,
+                                            sendbuf, sendcount, scounts, senddispls, sendtype, sendtypes,
+                                            recvbuf, recvcount, rcounts, recvdispls, recvtype, recvtypes,
+                                            root, comm);
+        }
+    }
+
+    if (sendbuf==MPI_IN_PLACE)
+        BigMPI_Error("BigMPI does not support in-place in the v-collectives.  Sorry. \n");
+
     if (method==P2P) {
 
+        /* Internal messages go to BigMPI's duplicate of comm so that they cannot match user traffic. */
+        bigmpi_context_t * ctx = BigMPI_Get_context(comm);
+
         switch(coll) {
             case ALLTOALLW: /* See page 173 of MPI-3 */
                 {
@@ -94,13 +215,13 @@ int BigMPI_Collective(bigmpi_collective_t coll, bigmpi_method_t method,
                     for (int i=0; i<size; i++) {
                         /* Pre-post all receives... */
                         MPIX_Irecv_x(recvbuf+recvdispls[i], recvcounts[i], recvtypes[i],
-                                     i /* source */, 0 /* tag */, comm, &reqs[i]);
+                                     i /* source */, 0 /* tag */, ctx->dup, &reqs[i]);
                     }
-                    for (int j=rank; j<(size+rank); j++) {
-                        /* Schedule communication in balanced way... */
-                        int i = j%size;
+                    for (int j=ctx->ring_pos; j<(size+ctx->ring_pos); j++) {
+                        /* Schedule communication in balanced way, in ring order... */
+                        int i = ctx->ring[j%size];
                         MPIX_Isend_x(sendbuf+senddispls[i], sendcounts[i], sendtypes[i],
-                                     i /* target */, 0 /* tag */, comm, &reqs[size+i]);
+                                     i /* target */, 0 /* tag */, ctx->dup, &reqs[size+i]);
                     }
                     MPI_Waitall(2*size, reqs, MPI_STATUSES_IGNORE);
                     free(reqs);
@@ -116,13 +237,13 @@ int BigMPI_Collective(bigmpi_collective_t coll, bigmpi_method_t method,
                     for (int i=0; i<size; i++) {
                         /* Pre-post all receives... */
                         MPIX_Irecv_x(recvbuf+recvdispls[i]*recvextent, recvcounts[i], recvtype,
-                                     i /* source */, 0 /* tag */, comm, &reqs[i]);
+                                     i /* source */, 0 /* tag */, ctx->dup, &reqs[i]);
                     }
-                    for (int j=rank; j<(size+rank); j++) {
-                        /* Schedule communication in balanced way... */
-                        int i = j%size;
+                    for (int j=ctx->ring_pos; j<(size+ctx->ring_pos); j++) {
+                        /* Schedule communication in balanced way, in ring order... */
+                        int i = ctx->ring[j%size];
                         MPIX_Isend_x(sendbuf+senddispls[i]*sendextent, sendcounts[i], sendtype,
-                                     i /* target */, 0 /* tag */, comm, &reqs[size+i]);
+                                     i /* target */, 0 /* tag */, ctx->dup, &reqs[size+i]);
                     }
                     MPI_Waitall(2*size, reqs, MPI_STATUSES_IGNORE);
                     free(reqs);
@@ -137,13 +258,13 @@ int BigMPI_Collective(bigmpi_collective_t coll, bigmpi_method_t method,
                     for (int i=0; i<size; i++) {
                         /* Pre-post all receives... */
                         MPIX_Irecv_x(recvbuf+recvdispls[i]*recvextent, recvcounts[i], recvtype,
-                                     i /* source */, 0 /* tag */, comm, &reqs[i]);
+                                     i /* source */, 0 /* tag */, ctx->dup, &reqs[i]);
                     }
-                    for (int j=rank; j<(size+rank); j++) {
-                        /* Schedule communication in balanced way... */
-                        int i = j%size;
+                    for (int j=ctx->ring_pos; j<(size+ctx->ring_pos); j++) {
+                        /* Schedule communication in balanced way, in ring order... */
+                        int i = ctx->ring[j%size];
                         MPIX_Isend_x(sendbuf, sendcount, sendtype,
-                                     i /* target */, 0 /* tag */, comm, &reqs[size+i]);
+                                     i /* target */, 0 /* tag */, ctx->dup, &reqs[size+i]);
                     }
                     MPI_Waitall(2*size, reqs, MPI_STATUSES_IGNORE);
                     free(reqs);
@@ -159,11 +280,11 @@ int BigMPI_Collective(bigmpi_collective_t coll, bigmpi_method_t method,
                         for (int i=0; i<size; i++) {
                             /* Use tag=0 because there is perfect pair-wise matching without it. */
                             MPIX_Irecv_x(recvbuf+recvdispls[i]*recvextent, recvcounts[i], recvtype,
-                                         i /* source */, 0 /* tag */, comm, &reqs[i+1]);
+                                         i /* source */, 0 /* tag */, ctx->dup, &reqs[i+1]);
                         }
                     }
                     MPIX_Isend_x(sendbuf, sendcount, sendtype,
-                                 root /* target */, 0 /* tag */, comm, &reqs[0]);
+                                 root /* target */, 0 /* tag */, ctx->dup, &reqs[0]);
                     MPI_Waitall(nreqs, reqs, MPI_STATUSES_IGNORE);
                     free(reqs);
                 }
@@ -175,14 +296,16 @@ int BigMPI_Collective(bigmpi_collective_t coll, bigmpi_method_t method,
                     if (rank==root) {
                         MPI_Aint lb /* unused */, sendextent;
                         MPI_Type_get_extent(sendtype, &lb, &sendextent);
-                        for (int i=0; i<size; i++) {
+                        for (int j=ctx->ring_pos; j<(size+ctx->ring_pos); j++) {
+                            /* Serve the processes in ring order... */
+                            int i = ctx->ring[j%size];
                             /* Use tag=0 because there is perfect pair-wise matching without it. */
                             MPIX_Isend_x(sendbuf+senddispls[i]*sendextent, sendcounts[i], sendtype,
-                                         i /* target */, 0 /* tag */, comm, &reqs[i+1]);
+                                         i /* target */, 0 /* tag */, ctx->dup, &reqs[i+1]);
                         }
                     }
                     MPIX_Irecv_x(recvbuf, recvcount, recvtype,
-                                 root /* source */, 0 /* tag */, comm, &reqs[0]);
+                                 root /* source */, 0 /* tag */, ctx->dup, &reqs[0]);
                     MPI_Waitall(nreqs, reqs, MPI_STATUSES_IGNORE);
                     free(reqs);
                 }
@@ -410,11 +533,11 @@ int BigMPI_Collective(bigmpi_collective_t coll, bigmpi_method_t method,
                 break;
         }
 
-        MPI_Comm comm_dist_graph;
-        BigMPI_Create_graph_comm(comm, root, &comm_dist_graph);
+        /* The graph communicator is created once per root and cached on comm. */
+        bigmpi_context_t * ctx = BigMPI_Get_context(comm);
+        MPI_Comm comm_dist_graph = BigMPI_Get_graph_comm(ctx, root);
         rc = MPI_Neighbor_alltoallw(sendbuf, newsendcounts, newsdispls, newsendtypes,
                                     recvbuf, newrecvcounts, newrdispls, newrecvtypes, comm_dist_graph);
-        MPI_Comm_free(&comm_dist_graph);
 
         for (int i=0; i<size; i++) {
             MPI_Type_free(&newsendtypes[i]);
@@ -5,12 +5,26 @@
 check_PROGRAMS += test/test_assert_x \
 		  test/test_contig_x \
 		  test/test_bcast_x \
+		  test/test_bcast_shared_x \
 		  test/test_reduce_x \
 		  test/test_allreduce_x \
+		  test/test_allreduce_ring_x \
+		  test/test_allreduce_rabenseifner_x \
+		  test/test_allreduce_stream_x \
+		  test/test_reduce_local_x \
+		  test/test_reduce_scatter_x \
+		  test/test_reproducible_x \
+		  test/test_scan_x \
+		  test/test_user_op_x \
+		  test/test_wire_format_x \
 		  test/test_gather_x \
 		  test/test_allgather_x \
 		  test/test_scatter_x \
 		  test/test_alltoall_x \
+		  test/test_vcollectives_x \
+		  test/test_icollectives_x \
+		  test/test_persistent_x \
+		  test/test_striped_x \
 		  test/test_send_recv_x \
 		  test/test_rsend_recv_x \
 		  test/test_ssend_recv_x \
@@ -25,12 +39,26 @@ check_PROGRAMS += test/test_assert_x \
 TESTS        += test/test_assert_x \
 		test/test_contig_x \
 		test/test_bcast_x \
+		test/test_bcast_shared_x \
 		test/test_reduce_x \
 		test/test_allreduce_x \
+		test/test_allreduce_ring_x \
+		test/test_allreduce_rabenseifner_x \
+		test/test_allreduce_stream_x \
+		test/test_reduce_local_x \
+		test/test_reduce_scatter_x \
+		test/test_reproducible_x \
+		test/test_scan_x \
+		test/test_user_op_x \
+		test/test_wire_format_x \
 		test/test_gather_x \
 		test/test_allgather_x \
 		test/test_scatter_x \
 		test/test_alltoall_x \
+		test/test_vcollectives_x \
+		test/test_icollectives_x \
+		test/test_persistent_x \
+		test/test_striped_x \
 		test/test_send_recv_x \
 		test/test_rsend_recv_x \
 		test/test_ssend_recv_x \
@@ -48,12 +76,26 @@ XFAIL_TESTS   += test/test_assert_x \
 test_test_assert_x_LDADD = libbigmpi.la
 test_test_contig_x_LDADD = libbigmpi.la
 test_test_bcast_x_LDADD = libbigmpi.la
+test_test_bcast_shared_x_LDADD = libbigmpi.la
 test_test_reduce_x_LDADD = libbigmpi.la
 test_test_allreduce_x_LDADD = libbigmpi.la
+test_test_allreduce_ring_x_LDADD = libbigmpi.la
+test_test_allreduce_rabenseifner_x_LDADD = libbigmpi.la
+test_test_allreduce_stream_x_LDADD = libbigmpi.la
+test_test_reduce_local_x_LDADD = libbigmpi.la
+test_test_reduce_scatter_x_LDADD = libbigmpi.la
+test_test_reproducible_x_LDADD = libbigmpi.la
+test_test_scan_x_LDADD = libbigmpi.la
+test_test_user_op_x_LDADD = libbigmpi.la
+test_test_wire_format_x_LDADD = libbigmpi.la
 test_test_gather_x_LDADD = libbigmpi.la
 test_test_allgather_x_LDADD = libbigmpi.la
 test_test_scatter_x_LDADD = libbigmpi.la
 test_test_alltoall_x_LDADD = libbigmpi.la
+test_test_vcollectives_x_LDADD = libbigmpi.la
+test_test_icollectives_x_LDADD = libbigmpi.la
+test_test_persistent_x_LDADD = libbigmpi.la
+test_test_striped_x_LDADD = libbigmpi.la
 test_test_send_recv_x_LDADD = libbigmpi.la
 test_test_rsend_recv_x_LDADD = libbigmpi.la
 test_test_ssend_recv_x_LDADD = libbigmpi.la
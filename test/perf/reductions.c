@@ -6,6 +6,7 @@
 #include <math.h>
 
 #include <mpi.h>
+#include "bigmpi.h"
 
 static int verify_doubles(double *buf, int count, double expected_value)
 {
@@ -17,8 +18,9 @@ static int verify_doubles(double *buf, int count, double expected_value)
     return errors;
 }
 
+/* These are static so that they do not collide with the ones of libbigmpi. */
 #define PASTE_BIGMPI_REDUCE_OP(OP)                                                   \
-void BigMPI_##OP##_x(void * invec, void * inoutvec, int * len, MPI_Datatype * type)  \
+static void BigMPI_##OP##_x(void * invec, void * inoutvec, int * len, MPI_Datatype * type)  \
 {                                                                                    \
     MPI_Reduce_local(invec,inoutvec,*len,*type,MPI_##OP);                            \
 }
@@ -39,7 +41,7 @@ PASTE_BIGMPI_REDUCE_OP(MINLOC)
 
 #undef PASTE_BIGMPI_REDUCE_OP
 
-int BigMPI_Op_create(MPI_Op op, MPI_Op * userop)
+static int BigMPI_Op_create(MPI_Op op, MPI_Op * userop)
 {
     int commute;
     MPI_Op_commutative(op, &commute);
@@ -65,7 +67,7 @@ int BigMPI_Op_create(MPI_Op op, MPI_Op * userop)
     return MPI_Op_create(bigfn, commute, userop);
 }
 
-int BigMPI_Allreduce(const void *sendbuf, void *recvbuf, int count,
+static int BigMPI_Allreduce(const void *sendbuf, void *recvbuf, int count,
                   MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
 {
     MPI_Op userop;
@@ -75,6 +77,64 @@ int BigMPI_Allreduce(const void *sendbuf, void *recvbuf, int count,
     return MPI_SUCCESS;
 }
 
+typedef struct { float  v; int i; } float_int_t;
+typedef struct { double v; int i; } double_int_t;
+typedef struct { int    v; int i; } int_int_t;
+
+/* Values with many ties, so that the index matters. */
+static void fill_pairs(void * buf, int n, MPI_Datatype type, int seed)
+{
+    for (int i=0; i<n; i++) {
+        int v = (i*(seed+3)+seed)%16;
+        int j = (i*seed)%97;
+        if      (type==MPI_FLOAT_INT)  { ((float_int_t*)buf)[i].v  = v; ((float_int_t*)buf)[i].i  = j; }
+        else if (type==MPI_DOUBLE_INT) { ((double_int_t*)buf)[i].v = v; ((double_int_t*)buf)[i].i = j; }
+        else if (type==MPI_2INT)       { ((int_int_t*)buf)[i].v    = v; ((int_int_t*)buf)[i].i    = j; }
+    }
+}
+
+/* Local MAXLOC or MINLOC on a pair type with MPI_Reduce_local and with the kernels of BigMPI. */
+static void bench_pairs(const char * name, MPI_Datatype type, MPI_Op op, int n, int rank)
+{
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    size_t bytes = (size_t)n*extent;
+
+    char * in   = malloc(bytes);
+    char * out1 = malloc(bytes);
+    char * out2 = malloc(bytes);
+
+    fill_pairs(in,   n, type, 1);
+    fill_pairs(out1, n, type, 2);
+    memcpy(out2, out1, bytes);
+
+    double t0, t1, dtmpi, dtbig;
+
+    t0 = MPI_Wtime();
+    MPI_Reduce_local(in, out1, n, type, op);
+    t1 = MPI_Wtime();
+    dtmpi = t1-t0;
+
+    t0 = MPI_Wtime();
+    MPIX_Reduce_local_x(in, out2, n, type, op);
+    t1 = MPI_Wtime();
+    dtbig = t1-t0;
+
+    int error = (memcmp(out1, out2, bytes)!=0);
+    if (error) {
+        printf("%d: %s results differ!\n", rank, name);
+    }
+    if (rank==0 && !error) {
+        /* Two buffers are read and one is written. */
+        printf("%-22s n = %d tmpi = %lf (%.2lf GB/s) tbigmpi = %lf (%.2lf GB/s)\n", name, n,
+               dtmpi, 3.e-9*bytes/dtmpi, dtbig, 3.e-9*bytes/dtbig);
+    }
+
+    free(in);
+    free(out1);
+    free(out2);
+}
+
 int main(int argc, char * argv[])
 {
     MPI_Init(&argc, &argv);
@@ -165,6 +225,14 @@ int main(int argc, char * argv[])
         printf("n = %d tmpi = %lf dtusr = %lf\n", n, dtmpi, dtusr);
     }
 
+    /* local reductions on the pair types */
+    bench_pairs("MPI_FLOAT_INT/MAXLOC",  MPI_FLOAT_INT,  MPI_MAXLOC, n, rank);
+    bench_pairs("MPI_FLOAT_INT/MINLOC",  MPI_FLOAT_INT,  MPI_MINLOC, n, rank);
+    bench_pairs("MPI_DOUBLE_INT/MAXLOC", MPI_DOUBLE_INT, MPI_MAXLOC, n, rank);
+    bench_pairs("MPI_DOUBLE_INT/MINLOC", MPI_DOUBLE_INT, MPI_MINLOC, n, rank);
+    bench_pairs("MPI_2INT/MAXLOC",       MPI_2INT,       MPI_MAXLOC, n, rank);
+    bench_pairs("MPI_2INT/MINLOC",       MPI_2INT,       MPI_MINLOC, n, rank);
+
     MPI_Finalize();
 
     return 0;
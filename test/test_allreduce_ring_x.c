@@ -0,0 +1,99 @@
+/* setenv */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+/* Run with 5 or more processes to cover rings of 3 and 5 processes. */
+
+/* Every element differs from its neighbours and between processes, so that segments that
+ * land in the wrong place are noticed.  All values and sums are exact in a double. */
+static double value(MPI_Count i, int rank)
+{
+    return (double)rank*1.e6 + (double)(i%100003);
+}
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    /* This has to be set before the first large allreduce. */
+    setenv("BIGMPI_ALLREDUCE_METHOD", "RING", 1);
+
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int l = (argc > 1) ? atoi(argv[1]) : 2;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    double * sbuf = NULL;
+    double * rbuf = NULL;
+
+    MPI_Alloc_mem(n*sizeof(double), MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem(n*sizeof(double), MPI_INFO_NULL, &rbuf);
+
+    for (MPI_Count i=0; i<n; i++) {
+        sbuf[i] = value(i, rank);
+    }
+
+    size_t errors = 0;
+
+    /* Rings of every size up to the number of processes, most of which are not powers of two. */
+    for (int s=1; s<=size; s++) {
+        MPI_Comm comm;
+        MPI_Comm_split(MPI_COMM_WORLD, rank<s ? 0 : MPI_UNDEFINED, rank, &comm);
+        if (comm==MPI_COMM_NULL) {
+            continue;
+        }
+
+        for (int inplace=0; inplace<2; inplace++) {
+            if (inplace) {
+                memcpy(rbuf, sbuf, (size_t)n*sizeof(double));
+            } else {
+                memset(rbuf, 0, (size_t)n*sizeof(double));
+            }
+            MPIX_Allreduce_x(inplace ? MPI_IN_PLACE : sbuf, rbuf, n, MPI_DOUBLE, MPI_SUM, comm);
+
+            for (MPI_Count i=0; i<n; i++) {
+                double sum = 0.0;
+                for (int r=0; r<s; r++) {
+                    sum += value(i, r);
+                }
+                if (rbuf[i]!=sum) {
+                    printf("%d: %sMPIX_Allreduce_x on %d processes: rbuf[%zu] = %lf (expected %lf - WRONG)\n",
+                           rank, inplace ? "in-place " : "", s, (size_t)i, rbuf[i], sum);
+                    errors++;
+                    break;
+                }
+            }
+        }
+
+        MPI_Comm_free(&comm);
+    }
+
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
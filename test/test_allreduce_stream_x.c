@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+#include "verify_buffer.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int l = (argc > 1) ? atoi(argv[1]) : 2;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    double * sbuf = NULL;
+    double * rbuf = NULL;
+
+    MPI_Aint bytes = n*sizeof(double);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &rbuf);
+
+    double val = (double)size*(size+1.)/2.;
+    size_t errors = 0;
+
+    for (int inplace=0; inplace<2; inplace++) {
+        double * in = inplace ? rbuf : sbuf;
+        memset(rbuf, 0, (size_t)bytes);
+
+        MPIX_Allreduce_stream stream;
+        MPIX_Allreduce_stream_begin_x(inplace ? MPI_IN_PLACE : sbuf, rbuf, n, MPI_DOUBLE, MPI_SUM,
+                                      MPI_COMM_WORLD, &stream);
+
+        /* Produce the vector in slices of different sizes, one of which is larger
+         * than INT_MAX, and push every slice as soon as it is done. */
+        MPI_Count offset = 0;
+        for (int k=0; offset<n; k++) {
+            MPI_Count slice = (k==1) ? test_int_max+m : m*(k+1);
+            if (slice > n-offset) slice = n-offset;
+            for (MPI_Count i=offset; i<offset+slice; i++) {
+                in[i] = (double)rank+1.;
+            }
+            MPIX_Allreduce_stream_push_x(stream, offset, slice);
+            offset += slice;
+        }
+
+        MPIX_Allreduce_stream_end_x(&stream);
+
+        size_t serrors = verify_doubles(rbuf, n, val);
+        if (serrors) {
+            printf("%d: %sstreaming allreduce had %zu errors out of %zu elements!\n",
+                   rank, inplace ? "in-place " : "", serrors, (size_t)n);
+        }
+        errors += serrors;
+    }
+
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -55,6 +55,18 @@ int main(int argc, char * argv[])
 
     size_t errors = verify_buffer(buf_recv, n, rank);
 
+    /* in-place collective communication: block i of every rank r carries r+2*i */
+    for (int i = 0; i < size; ++i) {
+        memset(buf_recv + i * n, rank+2*i, (size_t)n);
+    }
+    MPIX_Alltoall_x(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                    buf_recv, n, MPI_CHAR,
+                    MPI_COMM_WORLD);
+
+    for (int i = 0; i < size; ++i) {
+        errors += verify_buffer(buf_recv + i * n, n, i+2*rank);
+    }
+
     MPI_Free_mem(buf_send);
     MPI_Free_mem(buf_recv);
 
@@ -62,6 +62,29 @@ int main(int argc, char * argv[])
         errors += verify_buffer(buf_recv + i * n, n, i);
     }
 
+    /* in-place collective communication: every contribution starts out in its place in buf_recv */
+    memset(buf_recv, -1, (size_t)n * size);
+    memset(buf_recv + rank * n, rank, (size_t)n);
+    MPIX_Gather_x(rank==0 ? MPI_IN_PLACE : buf_recv + rank * n, n, MPI_CHAR,
+                  buf_recv, n, MPI_CHAR,
+                  0 /* root */, MPI_COMM_WORLD);
+
+    if (rank==0) {
+        for (int i = 0; i < size; ++i) {
+            errors += verify_buffer(buf_recv + i * n, n, i);
+        }
+    }
+
+    memset(buf_recv, -1, (size_t)n * size);
+    memset(buf_recv + rank * n, rank, (size_t)n);
+    MPIX_Allgather_x(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                     buf_recv, n, MPI_CHAR,
+                     MPI_COMM_WORLD);
+
+    for (int i = 0; i < size; ++i) {
+        errors += verify_buffer(buf_recv + i * n, n, i);
+    }
+
     MPI_Free_mem(buf_send);
     MPI_Free_mem(buf_recv);
 
@@ -0,0 +1,181 @@
+/* setenv */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+#include "verify_buffer.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+/* This exercises the pipelined implementation, which needs a progress thread.
+ * Run with BIGMPI_PROGRESS_THREAD=0 to exercise the native one instead. */
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    setenv("BIGMPI_PROGRESS_THREAD", "1", 0 /* overwrite */);
+
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (size<1) {
+        printf("Use 1 or more processes. \n");
+        MPI_Finalize();
+        return 1;
+    }
+
+    int l = (argc > 1) ? atoi(argv[1]) : 2;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    char * buf_send = NULL;
+    char * buf_recv = NULL;
+
+    MPI_Alloc_mem((MPI_Aint)n * size, MPI_INFO_NULL, &buf_send);
+    MPI_Alloc_mem((MPI_Aint)n * size, MPI_INFO_NULL, &buf_recv);
+
+    size_t errors = 0;
+    MPI_Request req;
+
+    /* broadcast */
+    memset(buf_recv, (rank==0) ? 1 : -1, (size_t)n);
+    MPIX_Ibcast_x(buf_recv, n, MPI_CHAR, 0 /* root */, MPI_COMM_WORLD, &req);
+    MPI_Wait(&req, MPI_STATUS_IGNORE);
+    errors += verify_buffer(buf_recv, n, 1);
+
+    /* gather */
+    memset(buf_send, rank, (size_t)n);
+    memset(buf_recv, -1,   (size_t)n * size);
+    MPIX_Igather_x(buf_send, n, MPI_CHAR, buf_recv, n, MPI_CHAR, 0 /* root */, MPI_COMM_WORLD, &req);
+    MPI_Wait(&req, MPI_STATUS_IGNORE);
+    if (rank==0) {
+        for (int i = 0; i < size; ++i) {
+            errors += verify_buffer(buf_recv + i * n, n, i);
+        }
+    }
+
+    /* gather into a type of the same signature, but another size */
+    {
+        MPI_Count half = n/2;
+        MPI_Datatype pair;
+        MPI_Type_contiguous(2, MPI_CHAR, &pair);
+        MPI_Type_commit(&pair);
+        memset(buf_send, rank, (size_t)n);
+        memset(buf_recv, -1,   (size_t)n * size);
+        MPIX_Igather_x(buf_send, 2*half, MPI_CHAR, buf_recv, half, pair, 0 /* root */, MPI_COMM_WORLD, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+        if (rank==0) {
+            for (int i = 0; i < size; ++i) {
+                errors += verify_buffer(buf_recv + i * 2*half, 2*half, i);
+            }
+        }
+        MPI_Type_free(&pair);
+    }
+
+    /* gather from triples into chars at an in-place root and into triples with holes,
+     * whose sizes do not divide the chunks that all processes cut the signature into */
+    {
+        MPI_Count third = n/3;
+        MPI_Datatype triple, sparse, tmptype;
+        MPI_Type_contiguous(3, MPI_CHAR, &triple);
+        MPI_Type_commit(&triple);
+        MPI_Type_vector(3, 1, 2, MPI_CHAR, &tmptype);
+        MPI_Type_create_resized(tmptype, 0, 6, &sparse);
+        MPI_Type_commit(&sparse);
+        MPI_Type_free(&tmptype);
+
+        memset(buf_send, rank, (size_t)n);
+        memset(buf_recv, (rank==0) ? 0 : -1, (size_t)n * size);
+        MPIX_Igather_x((rank==0) ? MPI_IN_PLACE : buf_send, third, triple,
+                       buf_recv, 3*third, MPI_CHAR, 0 /* root */, MPI_COMM_WORLD, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+        if (rank==0) {
+            for (int i = 0; i < size; ++i) {
+                errors += verify_buffer(buf_recv + i * 3*third, 3*third, i);
+            }
+        }
+
+        char * buf_sparse = NULL;
+        if (rank==0) {
+            MPI_Alloc_mem((MPI_Aint)6*third * size, MPI_INFO_NULL, &buf_sparse);
+            memset(buf_sparse, 0x7f, (size_t)6*third * size);
+        }
+        MPIX_Igather_x(buf_send, 3*third, MPI_CHAR, buf_sparse, third, sparse, 0 /* root */, MPI_COMM_WORLD, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+        if (rank==0) {
+            for (int i = 0; i < size; ++i) {
+                for (MPI_Count j = 0; j < 6*third; ++j) {
+                    errors += (buf_sparse[i * 6*third + j] != ((j%2==0) ? i : 0x7f));
+                }
+            }
+            MPI_Free_mem(buf_sparse);
+        }
+
+        MPI_Type_free(&triple);
+        MPI_Type_free(&sparse);
+    }
+
+    /* scatter */
+    if (rank==0) {
+        for (int i = 0; i < size; ++i) {
+            memset(buf_send + i * n, i+2, (size_t)n);
+        }
+    }
+    memset(buf_recv, -1, (size_t)n);
+    MPIX_Iscatter_x(buf_send, n, MPI_CHAR, buf_recv, n, MPI_CHAR, 0 /* root */, MPI_COMM_WORLD, &req);
+    MPI_Wait(&req, MPI_STATUS_IGNORE);
+    errors += verify_buffer(buf_recv, n, rank+2);
+
+    /* allgather, with and without MPI_IN_PLACE */
+    for (int in_place = 0; in_place <= 1; in_place++) {
+        memset(buf_send, rank, (size_t)n);
+        memset(buf_recv, -1,   (size_t)n * size);
+        if (in_place) {
+            memset(buf_recv + rank * n, rank, (size_t)n);
+        }
+        MPIX_Iallgather_x(in_place ? MPI_IN_PLACE : buf_send, n, MPI_CHAR,
+                          buf_recv, n, MPI_CHAR, MPI_COMM_WORLD, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+        for (int i = 0; i < size; ++i) {
+            errors += verify_buffer(buf_recv + i * n, n, i);
+        }
+    }
+
+    /* alltoall: block j of rank i carries i+2*j */
+    for (int j = 0; j < size; ++j) {
+        memset(buf_send + j * n, rank+2*j, (size_t)n);
+    }
+    memset(buf_recv, -1, (size_t)n * size);
+    MPIX_Ialltoall_x(buf_send, n, MPI_CHAR, buf_recv, n, MPI_CHAR, MPI_COMM_WORLD, &req);
+    MPI_Wait(&req, MPI_STATUS_IGNORE);
+    for (int i = 0; i < size; ++i) {
+        errors += verify_buffer(buf_recv + i * n, n, i+2*rank);
+    }
+
+    MPI_Free_mem(buf_send);
+    MPI_Free_mem(buf_recv);
+
+    if (errors > 0) {
+        printf("%d: There were %zu errors!\n", rank, errors);
+    }
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+#include "verify_buffer.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (size<1) {
+        printf("Use 1 or more processes. \n");
+        MPI_Finalize();
+        return 1;
+    }
+
+    int l = (argc > 1) ? atoi(argv[1]) : 2;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    size_t errors = 0;
+
+#ifdef BIGMPI_HAVE_PERSISTENT_COLLECTIVES
+
+    char * buf_send = NULL;
+    char * buf_recv = NULL;
+
+    MPI_Alloc_mem((MPI_Aint)n * size, MPI_INFO_NULL, &buf_send);
+    MPI_Alloc_mem((MPI_Aint)n * size, MPI_INFO_NULL, &buf_recv);
+
+    MPI_Request req[3];
+    MPIX_Bcast_init_x(buf_recv, n, MPI_CHAR, 0 /* root */, MPI_COMM_WORLD, MPI_INFO_NULL, &req[0]);
+    MPIX_Allgather_init_x(buf_send, n, MPI_CHAR, buf_recv, n, MPI_CHAR, MPI_COMM_WORLD, MPI_INFO_NULL, &req[1]);
+    MPIX_Alltoall_init_x(buf_send, n, MPI_CHAR, buf_recv, n, MPI_CHAR, MPI_COMM_WORLD, MPI_INFO_NULL, &req[2]);
+
+    double * sbuf = NULL;
+    double * rbuf = NULL;
+
+    MPI_Alloc_mem((MPI_Aint)n * sizeof(double), MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem((MPI_Aint)n * sizeof(double), MPI_INFO_NULL, &rbuf);
+
+    MPI_Request reqred;
+    MPIX_Allreduce_init_x(sbuf, rbuf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, MPI_INFO_NULL, &reqred);
+
+    /* Every request is started more than once, with new data every time. */
+    for (int iter = 0; iter < 2; iter++) {
+
+        memset(buf_recv, (rank==0) ? iter+1 : -1, (size_t)n);
+        MPI_Start(&req[0]);
+        MPI_Wait(&req[0], MPI_STATUS_IGNORE);
+        errors += verify_buffer(buf_recv, n, iter+1);
+
+        memset(buf_send, rank+iter, (size_t)n);
+        memset(buf_recv, -1,        (size_t)n * size);
+        MPI_Start(&req[1]);
+        MPI_Wait(&req[1], MPI_STATUS_IGNORE);
+        for (int i = 0; i < size; ++i) {
+            errors += verify_buffer(buf_recv + i * n, n, i+iter);
+        }
+
+        /* block j of rank i carries i+2*j+iter */
+        for (int j = 0; j < size; ++j) {
+            memset(buf_send + j * n, rank+2*j+iter, (size_t)n);
+        }
+        memset(buf_recv, -1, (size_t)n * size);
+        MPI_Start(&req[2]);
+        MPI_Wait(&req[2], MPI_STATUS_IGNORE);
+        for (int i = 0; i < size; ++i) {
+            errors += verify_buffer(buf_recv + i * n, n, i+2*rank+iter);
+        }
+
+        set_doubles(sbuf, n, (double)rank+iter);
+        set_doubles(rbuf, n, 0.0);
+        MPI_Start(&reqred);
+        MPI_Wait(&reqred, MPI_STATUS_IGNORE);
+        errors += verify_doubles(rbuf, n, (double)size*(size-1.)/2. + (double)size*iter);
+    }
+
+    /* Many live requests with different counts, the oldest of which is started last,
+     * so that its datatype has to outlive the creation of all the others. */
+    MPI_Request many[70];
+    for (int k = 0; k < 70; ++k) {
+        MPIX_Allreduce_init_x(sbuf, rbuf, n-k, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, MPI_INFO_NULL, &many[k]);
+    }
+    for (int k = 69; k >= 0; k -= 69) {
+        set_doubles(sbuf, n-k, (double)rank+k);
+        set_doubles(rbuf, n-k, 0.0);
+        MPI_Start(&many[k]);
+        MPI_Wait(&many[k], MPI_STATUS_IGNORE);
+        errors += verify_doubles(rbuf, n-k, (double)size*(size-1.)/2. + (double)size*k);
+    }
+    for (int k = 0; k < 70; ++k) {
+        MPI_Request_free(&many[k]);
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        MPI_Request_free(&req[i]);
+    }
+    MPI_Request_free(&reqred);
+
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+    MPI_Free_mem(buf_send);
+    MPI_Free_mem(buf_recv);
+
+#else
+    if (rank==0) {
+        printf("This MPI does not support persistent collectives.\n");
+    }
+#endif
+
+    if (errors > 0) {
+        printf("%d: There were %zu errors!\n", rank, errors);
+    }
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+/* setenv */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+typedef struct { double d; int i; } double_int_t;
+typedef struct { float  f; int i; } float_int_t;
+typedef struct { long   l; int i; } long_int_t;
+typedef struct { short  s; int i; } short_int_t;
+
+/* Small values, so that sums and products are exact in every type, except for
+ * the complex types, whose products have to be rounded like a*b-c*d without
+ * fused multiply-adds. */
+static void fill(void * buf, MPI_Count n, MPI_Datatype type, int seed)
+{
+    for (MPI_Count i=0; i<n; i++) {
+        int v = (int)((i*(seed+3)+seed)%4);
+        if      (type==MPI_DOUBLE)           ((double*)buf)[i]             = v;
+        else if (type==MPI_FLOAT)            ((float*)buf)[i]              = v;
+        else if (type==MPI_INT)              ((int*)buf)[i]                = v-1;
+        else if (type==MPI_LONG_LONG)        ((long long*)buf)[i]          = v-2;
+        else if (type==MPI_UNSIGNED_CHAR)    ((unsigned char*)buf)[i]      = (unsigned char)(v*37);
+        else if (type==MPI_BYTE)             ((unsigned char*)buf)[i]      = (unsigned char)(v*37);
+        else if (type==MPI_C_FLOAT_COMPLEX)  { ((float*)buf)[2*i]  = v/3.f; ((float*)buf)[2*i+1]  = ((v+seed)%3)/7.f; }
+        else if (type==MPI_C_DOUBLE_COMPLEX) { ((double*)buf)[2*i] = v/3.;  ((double*)buf)[2*i+1] = ((v+seed)%3)/7.; }
+        /* Many ties, so that the smaller index has to win often. */
+        else if (type==MPI_DOUBLE_INT)       { ((double_int_t*)buf)[i].d = v; ((double_int_t*)buf)[i].i = (int)((i*seed)%7); }
+        else if (type==MPI_FLOAT_INT)        { ((float_int_t*)buf)[i].f  = v; ((float_int_t*)buf)[i].i  = (int)((i*seed)%7); }
+        else if (type==MPI_LONG_INT)         { ((long_int_t*)buf)[i].l   = v; ((long_int_t*)buf)[i].i   = (int)((i*seed)%7); }
+        else if (type==MPI_SHORT_INT)        { ((short_int_t*)buf)[i].s  = v; ((short_int_t*)buf)[i].i  = (int)((i*seed)%7); }
+        else if (type==MPI_2INT)             { ((int*)buf)[2*i] = v; ((int*)buf)[2*i+1] = (int)((i*seed)%7); }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    /* Split every reduction of at least 2 MiB over three threads, unevenly. */
+    setenv("BIGMPI_REDUCE_THREADS", "3", 0 /* overwrite */);
+
+    MPI_Init(&argc, &argv);
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    int l = (argc > 1) ? atoi(argv[1]) : 2;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    const struct { MPI_Datatype type; MPI_Op op; const char * name; } cases[] = {
+        { MPI_DOUBLE,           MPI_SUM,    "MPI_DOUBLE/MPI_SUM"           },
+        { MPI_DOUBLE,           MPI_MAX,    "MPI_DOUBLE/MPI_MAX"           },
+        { MPI_DOUBLE,           MPI_PROD,   "MPI_DOUBLE/MPI_PROD"          },
+        { MPI_FLOAT,            MPI_MIN,    "MPI_FLOAT/MPI_MIN"            },
+        { MPI_INT,              MPI_SUM,    "MPI_INT/MPI_SUM"              },
+        { MPI_INT,              MPI_LAND,   "MPI_INT/MPI_LAND"             },
+        { MPI_INT,              MPI_BXOR,   "MPI_INT/MPI_BXOR"             },
+        { MPI_LONG_LONG,        MPI_PROD,   "MPI_LONG_LONG/MPI_PROD"       },
+        { MPI_LONG_LONG,        MPI_LXOR,   "MPI_LONG_LONG/MPI_LXOR"       },
+        { MPI_UNSIGNED_CHAR,    MPI_MAX,    "MPI_UNSIGNED_CHAR/MPI_MAX"    },
+        { MPI_UNSIGNED_CHAR,    MPI_LOR,    "MPI_UNSIGNED_CHAR/MPI_LOR"    },
+        { MPI_BYTE,             MPI_BOR,    "MPI_BYTE/MPI_BOR"             },
+        { MPI_BYTE,             MPI_BAND,   "MPI_BYTE/MPI_BAND"            },
+        { MPI_C_FLOAT_COMPLEX,  MPI_PROD,   "MPI_C_FLOAT_COMPLEX/MPI_PROD" },
+        { MPI_C_DOUBLE_COMPLEX, MPI_SUM,    "MPI_C_DOUBLE_COMPLEX/MPI_SUM" },
+        { MPI_C_DOUBLE_COMPLEX, MPI_PROD,   "MPI_C_DOUBLE_COMPLEX/MPI_PROD"},
+        { MPI_DOUBLE_INT,       MPI_MAXLOC, "MPI_DOUBLE_INT/MPI_MAXLOC"    },
+        { MPI_DOUBLE_INT,       MPI_MINLOC, "MPI_DOUBLE_INT/MPI_MINLOC"    },
+        { MPI_FLOAT_INT,        MPI_MAXLOC, "MPI_FLOAT_INT/MPI_MAXLOC"     },
+        { MPI_LONG_INT,         MPI_MINLOC, "MPI_LONG_INT/MPI_MINLOC"      },
+        { MPI_SHORT_INT,        MPI_MAXLOC, "MPI_SHORT_INT/MPI_MAXLOC"     },
+        { MPI_2INT,             MPI_MINLOC, "MPI_2INT/MPI_MINLOC"          },
+    };
+    const int ncases = (int)(sizeof(cases)/sizeof(cases[0]));
+
+    size_t errors = 0;
+    for (int k=0; k<ncases; k++) {
+        MPI_Aint lb /* unused */, extent;
+        MPI_Type_get_extent(cases[k].type, &lb, &extent);
+        MPI_Aint bytes = n*extent;
+
+        char * in  = NULL;
+        char * out = NULL;
+        char * ref = NULL;
+        MPI_Alloc_mem(bytes, MPI_INFO_NULL, &in);
+        MPI_Alloc_mem(bytes, MPI_INFO_NULL, &out);
+        MPI_Alloc_mem(bytes, MPI_INFO_NULL, &ref);
+
+        fill(in,  n, cases[k].type, 1);
+        fill(out, n, cases[k].type, 2);
+        memcpy(ref, out, (size_t)bytes);
+
+        MPIX_Reduce_local_x(in, out, n, cases[k].type, cases[k].op);
+
+        for (MPI_Count i=0; i<n; i+=test_int_max) {
+            int c = (int)((n-i) < test_int_max ? (n-i) : test_int_max);
+            MPI_Reduce_local(in+i*extent, ref+i*extent, c, cases[k].type, cases[k].op);
+        }
+
+        if (memcmp(out, ref, (size_t)bytes)!=0) {
+            printf("%d: %s is WRONG\n", rank, cases[k].name);
+            errors++;
+        }
+
+        MPI_Free_mem(in);
+        MPI_Free_mem(out);
+        MPI_Free_mem(ref);
+    }
+
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
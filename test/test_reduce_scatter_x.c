@@ -0,0 +1,296 @@
+/* setenv */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+#include "verify_buffer.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+/* A non-commutative op whose result is the input of rank 0. */
+static void first(void * invec, void * inoutvec, int * len, MPI_Datatype * datatype)
+{
+    memcpy(inoutvec, invec, (size_t)*len*sizeof(double));
+}
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    /* Large nonblocking reduce-scatters are ring reduce-scatters with asynchronous progress.
+     * Run with BIGMPI_PROGRESS_THREAD=0 to exercise the native ones instead. */
+    setenv("BIGMPI_PROGRESS_THREAD", "1", 0 /* overwrite */);
+
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int l = (argc > 1) ? atoi(argv[1]) : 1;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    double * sbuf = NULL;
+    double * rbuf = NULL;
+
+    MPI_Aint bytes = n*size*sizeof(double);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &rbuf);
+
+    /* Block b is filled with rank+1+b, so that every process gets a different result. */
+    for (int b=0; b<size; b++) {
+        for (MPI_Count i=0; i<n; i++) {
+            sbuf[b*n+i] = (double)rank+1.+b;
+        }
+    }
+    for (MPI_Count i=0; i<n; i++) {
+        rbuf[i] = 0.0;
+    }
+
+    double val = (double)size*(size+1.)/2. + (double)size*rank;
+    size_t errors = 0;
+
+    MPIX_Reduce_scatter_block_x(sbuf, rbuf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    errors += verify_doubles(rbuf, n, val);
+    if (errors) {
+        printf("%d: MPIX_Reduce_scatter_block_x had %zu errors out of %zu elements!\n",
+               rank, errors, (size_t)n);
+    }
+
+    /* in-place */
+    memcpy(rbuf, sbuf, (size_t)bytes);
+    MPIX_Reduce_scatter_block_x(MPI_IN_PLACE, rbuf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    size_t ierrors = verify_doubles(rbuf, n, val);
+    if (ierrors) {
+        printf("%d: in-place MPIX_Reduce_scatter_block_x had %zu errors out of %zu elements!\n",
+               rank, ierrors, (size_t)n);
+    }
+    errors += ierrors;
+
+    /* nonblocking, in place or not */
+    for (int inplace=0; inplace<2; inplace++) {
+        if (inplace) {
+            memcpy(rbuf, sbuf, (size_t)bytes);
+        } else {
+            memset(rbuf, 0, (size_t)bytes);
+        }
+        MPI_Request req;
+        MPIX_Ireduce_scatter_block_x(inplace ? MPI_IN_PLACE : sbuf, rbuf, n, MPI_DOUBLE, MPI_SUM,
+                                     MPI_COMM_WORLD, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+        size_t nerrors = verify_doubles(rbuf, n, val);
+        if (nerrors) {
+            printf("%d: %sMPIX_Ireduce_scatter_block_x had %zu errors out of %zu elements!\n",
+                   rank, inplace ? "in-place " : "", nerrors, (size_t)n);
+        }
+        errors += nerrors;
+    }
+
+    /* Nonblocking collectives must not synchronize: rank 0 starts the reduce-scatter
+     * before it sends to rank 1, which only starts it after the message arrived. */
+    if (size>1) {
+        int token = 42;
+        MPI_Request req;
+        memset(rbuf, 0, (size_t)bytes);
+        if (rank==1) {
+            MPI_Recv(&token, 1, MPI_INT, 0 /* source */, 0 /* tag */, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        MPIX_Ireduce_scatter_block_x(sbuf, rbuf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &req);
+        if (rank==0) {
+            MPI_Send(&token, 1, MPI_INT, 1 /* dest */, 0 /* tag */, MPI_COMM_WORLD);
+        }
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+        size_t nerrors = verify_doubles(rbuf, n, val);
+        if (nerrors) {
+            printf("%d: MPIX_Ireduce_scatter_block_x started before a send had %zu errors out of %zu elements!\n",
+                   rank, nerrors, (size_t)n);
+        }
+        errors += nerrors;
+    }
+
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+
+    /* Uneven blocks, some of which are small and some of which are large. */
+    MPI_Count * counts = malloc(size*sizeof(MPI_Count));
+    MPI_Count total = 0;
+    for (int b=0; b<size; b++) {
+        counts[b] = (b%2==0) ? n+b*m : m+b;
+        total += counts[b];
+    }
+
+    bytes = total*sizeof(double);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &rbuf);
+
+    for (int b=0, i=0; b<size; b++) {
+        for (MPI_Count j=0; j<counts[b]; j++, i++) {
+            sbuf[i] = (double)rank+1.+b;
+        }
+    }
+
+    for (int k=0; k<4; k++) {
+        int inplace  = k%2;
+        int blocking = k<2;
+        if (inplace) {
+            memcpy(rbuf, sbuf, (size_t)bytes);
+        } else {
+            memset(rbuf, 0, (size_t)bytes);
+        }
+        const void * in = inplace ? MPI_IN_PLACE : sbuf;
+        if (blocking) {
+            MPIX_Reduce_scatter_x(in, rbuf, counts, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        } else {
+            MPI_Request req;
+            MPIX_Ireduce_scatter_x(in, rbuf, counts, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &req);
+            MPI_Wait(&req, MPI_STATUS_IGNORE);
+        }
+        size_t verrors = verify_doubles(rbuf, counts[rank], val);
+        if (verrors) {
+            printf("%d: %s%s had %zu errors out of %zu elements!\n",
+                   rank, inplace ? "in-place " : "", blocking ? "MPIX_Reduce_scatter_x" : "MPIX_Ireduce_scatter_x",
+                   verrors, (size_t)counts[rank]);
+        }
+        errors += verrors;
+    }
+
+    free(counts);
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+
+    /* The same with uneven blocks. */
+    for (int large=0; large<2 && size>1; large++) {
+        counts = malloc(size*sizeof(MPI_Count));
+        total = 0;
+        for (int b=0; b<size; b++) {
+            counts[b] = (large && b==0) ? n : m+b;
+            total += counts[b];
+        }
+
+        MPI_Alloc_mem(total*sizeof(double), MPI_INFO_NULL, &sbuf);
+        MPI_Alloc_mem(total*sizeof(double), MPI_INFO_NULL, &rbuf);
+        for (int b=0, i=0; b<size; b++) {
+            for (MPI_Count j=0; j<counts[b]; j++, i++) {
+                sbuf[i] = (double)rank+1.+b;
+            }
+        }
+        memset(rbuf, 0, (size_t)counts[rank]*sizeof(double));
+
+        int token = 42;
+        MPI_Request req;
+        if (rank==1) {
+            MPI_Recv(&token, 1, MPI_INT, 0 /* source */, 0 /* tag */, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        MPIX_Ireduce_scatter_x(sbuf, rbuf, counts, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &req);
+        if (rank==0) {
+            MPI_Send(&token, 1, MPI_INT, 1 /* dest */, 0 /* tag */, MPI_COMM_WORLD);
+        }
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+
+        size_t verrors = verify_doubles(rbuf, counts[rank], val);
+        if (verrors) {
+            printf("%d: %s MPIX_Ireduce_scatter_x started before a send had %zu errors out of %zu elements!\n",
+                   rank, large ? "large" : "small", verrors, (size_t)counts[rank]);
+        }
+        errors += verrors;
+
+        free(counts);
+        MPI_Free_mem(sbuf);
+        MPI_Free_mem(rbuf);
+    }
+
+    /* A non-commutative op on uneven blocks, large and small.  Only ops created with
+     * MPIX_Op_create_x can be used at large counts. */
+    MPI_Op op_x, op;
+    MPIX_Op_create_x(first, 0 /* commute */, &op_x);
+    MPI_Op_create(first, 0 /* commute */, &op);
+    for (int large=0; large<2; large++) {
+        counts = malloc(size*sizeof(MPI_Count));
+        total = 0;
+        for (int b=0; b<size; b++) {
+            counts[b] = (large && b%2==0) ? n+b*m : m+b;
+            total += counts[b];
+        }
+
+        MPI_Alloc_mem(total*sizeof(double), MPI_INFO_NULL, &sbuf);
+        MPI_Alloc_mem(total*sizeof(double), MPI_INFO_NULL, &rbuf);
+        for (int b=0, i=0; b<size; b++) {
+            for (MPI_Count j=0; j<counts[b]; j++, i++) {
+                sbuf[i] = (double)rank+1.+b;
+            }
+        }
+
+        for (int k=0; k<(large ? 2 : 3); k++) {
+            int blocking = (k==0);
+            memset(rbuf, 0, (size_t)counts[rank]*sizeof(double));
+            if (blocking) {
+                MPIX_Reduce_scatter_x(sbuf, rbuf, counts, MPI_DOUBLE, op_x, MPI_COMM_WORLD);
+            } else {
+                MPI_Request req;
+                MPIX_Ireduce_scatter_x(sbuf, rbuf, counts, MPI_DOUBLE, (k==1) ? op_x : op, MPI_COMM_WORLD, &req);
+                MPI_Wait(&req, MPI_STATUS_IGNORE);
+            }
+            size_t verrors = verify_doubles(rbuf, counts[rank], 1.+rank);
+            if (verrors) {
+                printf("%d: %s non-commutative %s%s had %zu errors out of %zu elements!\n",
+                       rank, large ? "large" : "small", blocking ? "MPIX_Reduce_scatter_x" : "MPIX_Ireduce_scatter_x",
+                       (k==2) ? " with MPI_Op_create" : "", verrors, (size_t)counts[rank]);
+            }
+            errors += verrors;
+        }
+
+        free(counts);
+        MPI_Free_mem(sbuf);
+        MPI_Free_mem(rbuf);
+    }
+
+    /* The same with even blocks. */
+    MPI_Alloc_mem(n*size*sizeof(double), MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem(n*sizeof(double), MPI_INFO_NULL, &rbuf);
+    for (int b=0; b<size; b++) {
+        for (MPI_Count i=0; i<n; i++) {
+            sbuf[b*n+i] = (double)rank+1.+b;
+        }
+    }
+    for (int blocking=0; blocking<2; blocking++) {
+        memset(rbuf, 0, (size_t)n*sizeof(double));
+        if (blocking) {
+            MPIX_Reduce_scatter_block_x(sbuf, rbuf, n, MPI_DOUBLE, op_x, MPI_COMM_WORLD);
+        } else {
+            MPI_Request req;
+            MPIX_Ireduce_scatter_block_x(sbuf, rbuf, n, MPI_DOUBLE, op_x, MPI_COMM_WORLD, &req);
+            MPI_Wait(&req, MPI_STATUS_IGNORE);
+        }
+        size_t verrors = verify_doubles(rbuf, n, 1.+rank);
+        if (verrors) {
+            printf("%d: non-commutative %s had %zu errors out of %zu elements!\n",
+                   rank, blocking ? "MPIX_Reduce_scatter_block_x" : "MPIX_Ireduce_scatter_block_x",
+                   verrors, (size_t)n);
+        }
+        errors += verrors;
+    }
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+
+    MPI_Op_free(&op);
+    MPIX_Op_free_x(&op_x);
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -79,6 +79,82 @@ int main(int argc, char * argv[])
         }
     }
 
+    /* in-place: the input of the root is in rbuf */
+    for (MPI_Count i=0; i<n; i++) {
+        rbuf[i] = (double)rank+1.;
+    }
+
+    /* collective communication */
+    MPIX_Reduce_x(rank==0 ? MPI_IN_PLACE : sbuf, rbuf, n, MPI_DOUBLE, MPI_SUM, 0 /* root */, MPI_COMM_WORLD);
+
+    if (rank==0) {
+        double val = (double)size*(size+1.)/2.;
+        size_t e = verify_doubles(rbuf, n, val);
+        if (e) {
+            printf("There were %zu errors out of %zu elements in the in-place reduce!\n", e, (size_t)n);
+            fflush(stdout);
+        }
+        errors += e;
+    }
+
+    for (MPI_Count i=0; i<n; i++) {
+        rbuf[i] = (double)rank+1.;
+    }
+
+    /* collective communication */
+    MPIX_Allreduce_x(MPI_IN_PLACE, rbuf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+    {
+        double val = (double)size*(size+1.)/2.;
+        size_t e = verify_doubles(rbuf, n, val);
+        if (e) {
+            printf("There were %zu errors out of %zu elements in the in-place allreduce!\n", e, (size_t)n);
+            fflush(stdout);
+        }
+        errors += e;
+    }
+
+    /* nonblocking in-place: the input of the root and of the allreduce is in rbuf */
+    for (MPI_Count i=0; i<n; i++) {
+        rbuf[i] = (double)rank+1.;
+    }
+
+    {
+        MPI_Request req;
+        MPIX_Ireduce_x(rank==0 ? MPI_IN_PLACE : sbuf, rbuf, n, MPI_DOUBLE, MPI_SUM, 0 /* root */, MPI_COMM_WORLD, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+    }
+
+    if (rank==0) {
+        double val = (double)size*(size+1.)/2.;
+        size_t e = verify_doubles(rbuf, n, val);
+        if (e) {
+            printf("There were %zu errors out of %zu elements in the in-place ireduce!\n", e, (size_t)n);
+            fflush(stdout);
+        }
+        errors += e;
+    }
+
+    for (MPI_Count i=0; i<n; i++) {
+        rbuf[i] = (double)rank+1.;
+    }
+
+    {
+        MPI_Request req;
+        MPIX_Iallreduce_x(MPI_IN_PLACE, rbuf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+    }
+
+    {
+        double val = (double)size*(size+1.)/2.;
+        size_t e = verify_doubles(rbuf, n, val);
+        if (e) {
+            printf("There were %zu errors out of %zu elements in the in-place iallreduce!\n", e, (size_t)n);
+            fflush(stdout);
+        }
+        errors += e;
+    }
+
     MPI_Free_mem(sbuf);
     MPI_Free_mem(rbuf);
 
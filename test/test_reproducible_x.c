@@ -0,0 +1,201 @@
+/* setenv */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+/* Values of very different magnitudes, so that the sum depends on the order of the operands. */
+static double value(MPI_Count i, int rank)
+{
+    return (1.0+(double)((i+rank)%13))/3.0 * ((rank%3==0) ? 1.e10 : ((rank%3==1) ? -1.e-6 : 1.0));
+}
+
+/* Complex factors close to the unit circle, so that long products neither overflow nor
+ * underflow, but whose rounding depends on the order of the factors. */
+static void cvalue(MPI_Count i, int rank, double z[2])
+{
+    double t = (double)((i+3*rank)%11)/11.;
+    z[0] = 0.6 + 0.05*t + 1.e-3*rank;
+    z[1] = 0.8 - 0.03*t;
+}
+
+/* Checks the complex product of n elements against the one of rank 0 (exactly) and
+ * against the product in rank order (with a relative tolerance). */
+static size_t check_prod(const double * rbuf, MPI_Count n, int rank, int size, const char * name)
+{
+    double * ref = NULL;
+    MPI_Alloc_mem(2*n*sizeof(double), MPI_INFO_NULL, &ref);
+    if (rank==0) {
+        memcpy(ref, rbuf, (size_t)n*2*sizeof(double));
+    }
+    MPIX_Bcast_x(ref, n, MPI_C_DOUBLE_COMPLEX, 0, MPI_COMM_WORLD);
+
+    size_t errors = 0;
+    if (memcmp(ref, rbuf, (size_t)n*2*sizeof(double))!=0) {
+        printf("%d: %s differs from rank 0 (WRONG)\n", rank, name);
+        errors++;
+    }
+    for (MPI_Count i=0; i<n; i++) {
+        double p[2] = { 1.0, 0.0 };
+        for (int r=0; r<size; r++) {
+            double z[2];
+            cvalue(i, r, z);
+            double re = p[0]*z[0] - p[1]*z[1];
+            double im = p[0]*z[1] + p[1]*z[0];
+            p[0] = re;
+            p[1] = im;
+        }
+        double dre = rbuf[2*i]-p[0], dim = rbuf[2*i+1]-p[1];
+        if (dre*dre+dim*dim > 1.e-24*(p[0]*p[0]+p[1]*p[1])) {
+            printf("%d: %s rbuf[%zu] = (%lf,%lf) (expected (%lf,%lf) - WRONG)\n",
+                   rank, name, (size_t)i, rbuf[2*i], rbuf[2*i+1], p[0], p[1]);
+            errors++;
+            break;
+        }
+    }
+
+    MPI_Free_mem(ref);
+    return errors;
+}
+
+/* Checks recvbuf of n elements against the result of rank 0 and against the sum in
+ * rank order with a relative tolerance.  The first check is exact. */
+static size_t check(const double * rbuf, MPI_Count n, int rank, int size, const char * name)
+{
+    double * ref = NULL;
+    MPI_Alloc_mem(n*sizeof(double), MPI_INFO_NULL, &ref);
+    if (rank==0) {
+        memcpy(ref, rbuf, (size_t)n*sizeof(double));
+    }
+    MPIX_Bcast_x(ref, n, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    size_t errors = 0;
+    if (memcmp(ref, rbuf, (size_t)n*sizeof(double))!=0) {
+        printf("%d: %s differs from rank 0 (WRONG)\n", rank, name);
+        errors++;
+    }
+    for (MPI_Count i=0; i<n; i++) {
+        double sum = 0.0;
+        for (int r=0; r<size; r++) {
+            sum += value(i, r);
+        }
+        double diff = (rbuf[i] > sum) ? rbuf[i]-sum : sum-rbuf[i];
+        if (diff > 1.e-12*1.e10*size) {
+            printf("%d: %s rbuf[%zu] = %lf (expected %lf - WRONG)\n", rank, name, (size_t)i, rbuf[i], sum);
+            errors++;
+            break;
+        }
+    }
+
+    MPI_Free_mem(ref);
+    return errors;
+}
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    /* This has to be set before the first reduction. */
+    setenv("BIGMPI_REPRODUCIBLE", "1", 1);
+
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int l = (argc > 1) ? atoi(argv[1]) : 2;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    double * sbuf  = NULL;
+    double * rbuf  = NULL;
+    double * rbuf2 = NULL;
+
+    MPI_Aint bytes = n*sizeof(double);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &rbuf);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &rbuf2);
+
+    for (MPI_Count i=0; i<n; i++) {
+        sbuf[i] = value(i, rank);
+    }
+
+    size_t errors = 0;
+
+    /* large and small */
+    MPI_Count counts[2] = { n, m };
+    for (int k=0; k<2; k++) {
+        MPI_Count c = counts[k];
+
+        MPIX_Allreduce_x(sbuf, rbuf, c, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        errors += check(rbuf, c, rank, size, "MPIX_Allreduce_x");
+
+        /* Every variant has to give exactly the same result. */
+        memcpy(rbuf2, sbuf, (size_t)c*sizeof(double));
+        MPIX_Allreduce_x(MPI_IN_PLACE, rbuf2, c, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        if (memcmp(rbuf, rbuf2, (size_t)c*sizeof(double))!=0) {
+            printf("%d: in-place MPIX_Allreduce_x differs (WRONG)\n", rank);
+            errors++;
+        }
+
+        for (int root=0; root<size; root++) {
+            memset(rbuf2, 0, (size_t)c*sizeof(double));
+            MPIX_Reduce_x(sbuf, rbuf2, c, MPI_DOUBLE, MPI_SUM, root, MPI_COMM_WORLD);
+            if (rank==root && memcmp(rbuf, rbuf2, (size_t)c*sizeof(double))!=0) {
+                printf("%d: MPIX_Reduce_x to %d differs (WRONG)\n", rank, root);
+                errors++;
+            }
+        }
+    }
+
+    /* complex products, large and small, of half as many elements */
+    for (MPI_Count i=0; i<n/2; i++) {
+        cvalue(i, rank, &sbuf[2*i]);
+    }
+    for (int k=0; k<2; k++) {
+        MPI_Count c = counts[k]/2;
+
+        MPIX_Allreduce_x(sbuf, rbuf, c, MPI_C_DOUBLE_COMPLEX, MPI_PROD, MPI_COMM_WORLD);
+        errors += check_prod(rbuf, c, rank, size, "complex MPIX_Allreduce_x");
+
+        memcpy(rbuf2, sbuf, (size_t)c*2*sizeof(double));
+        MPIX_Allreduce_x(MPI_IN_PLACE, rbuf2, c, MPI_C_DOUBLE_COMPLEX, MPI_PROD, MPI_COMM_WORLD);
+        if (memcmp(rbuf, rbuf2, (size_t)c*2*sizeof(double))!=0) {
+            printf("%d: in-place complex MPIX_Allreduce_x differs (WRONG)\n", rank);
+            errors++;
+        }
+
+        for (int root=0; root<size; root++) {
+            memset(rbuf2, 0, (size_t)c*2*sizeof(double));
+            MPIX_Reduce_x(sbuf, rbuf2, c, MPI_C_DOUBLE_COMPLEX, MPI_PROD, root, MPI_COMM_WORLD);
+            if (rank==root && memcmp(rbuf, rbuf2, (size_t)c*2*sizeof(double))!=0) {
+                printf("%d: complex MPIX_Reduce_x to %d differs (WRONG)\n", rank, root);
+                errors++;
+            }
+        }
+    }
+
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+    MPI_Free_mem(rbuf2);
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+#include "verify_buffer.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int l = (argc > 1) ? atoi(argv[1]) : 2;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    double * sbuf = NULL;
+    double * rbuf = NULL;
+
+    MPI_Aint bytes = n*sizeof(double);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &rbuf);
+
+    for (MPI_Count i=0; i<n; i++) {
+        sbuf[i] = (double)rank+1.;
+    }
+
+    size_t errors = 0;
+
+    /* 0: blocking, 1: blocking in-place, 2: nonblocking, 3: nonblocking in-place,
+     * first for the inclusive and then for the exclusive scan. */
+    for (int k=0; k<8; k++) {
+        int exclusive = k/4;
+        int inplace   = k%2;
+        int blocking  = (k%4)<2;
+
+        if (inplace) {
+            memcpy(rbuf, sbuf, (size_t)bytes);
+        } else {
+            memset(rbuf, 0, (size_t)bytes);
+        }
+        const void * in = inplace ? MPI_IN_PLACE : sbuf;
+
+        if (blocking) {
+            if (exclusive) MPIX_Exscan_x(in, rbuf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+            else           MPIX_Scan_x(in, rbuf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        } else {
+            MPI_Request req;
+            if (exclusive) MPIX_Iexscan_x(in, rbuf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &req);
+            else           MPIX_Iscan_x(in, rbuf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &req);
+            MPI_Wait(&req, MPI_STATUS_IGNORE);
+        }
+
+        /* The result of an exclusive scan is undefined at rank 0. */
+        if (exclusive && rank==0) continue;
+
+        double val = exclusive ? (double)rank*(rank+1.)/2. : (rank+1.)*(rank+2.)/2.;
+        size_t kerrors = verify_doubles(rbuf, n, val);
+        if (kerrors) {
+            printf("%d: %s%s%s had %zu errors out of %zu elements!\n", rank,
+                   inplace ? "in-place " : "", blocking ? "MPIX_" : "MPIX_I",
+                   exclusive ? "exscan_x" : "scan_x", kerrors, (size_t)n);
+        }
+        errors += kerrors;
+    }
+
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
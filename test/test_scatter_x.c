@@ -57,6 +57,14 @@ int main(int argc, char * argv[])
 
     size_t errors = verify_buffer(buf_recv, n, rank);
 
+    /* in-place collective communication: the root keeps its block where it is */
+    memset(buf_recv, -1, (size_t)n);
+    MPIX_Scatter_x(buf_send, n, MPI_CHAR,
+                   rank==0 ? MPI_IN_PLACE : buf_recv, n, MPI_CHAR,
+                   0 /* root */, MPI_COMM_WORLD);
+
+    errors += verify_buffer(rank==0 ? buf_send : buf_recv, n, rank);
+
     MPI_Free_mem(buf_send);
     MPI_Free_mem(buf_recv);
 
@@ -0,0 +1,138 @@
+/* setenv */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+/* Every element differs from its neighbours and between processes, so that chunks that
+ * land in the wrong place are noticed.  All values are exact in a double. */
+static double value(MPI_Count i, int rank)
+{
+    return (double)rank*1.e6 + (double)(i%100003);
+}
+
+static size_t check(const double * buf, MPI_Count n, double (*expected)(MPI_Count, int), int arg,
+                    int rank, const char * name)
+{
+    for (MPI_Count i=0; i<n; i++) {
+        if (buf[i]!=expected(i, arg)) {
+            printf("%d: %s buf[%zu] = %lf (expected %lf - WRONG)\n",
+                   rank, name, (size_t)i, buf[i], expected(i, arg));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int commsize;
+
+/* sum over all ranks r of (r+1)*value(i, 0) */
+static double sum(MPI_Count i, int unused)
+{
+    return value(i, 0)*commsize*(commsize+1.)/2.;
+}
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    /* Stripe everything of at least 4 KiB over three communicators. */
+    setenv("BIGMPI_STRIPES", "3", 1);
+    setenv("BIGMPI_STRIPE_THRESHOLD", "4096", 1);
+
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    commsize = size;
+
+    int l = (argc > 1) ? atoi(argv[1]) : 1;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    double * sbuf = NULL;
+    double * rbuf = NULL;
+
+    MPI_Alloc_mem(n*sizeof(double), MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem(n*size*sizeof(double), MPI_INFO_NULL, &rbuf);
+
+    MPI_Datatype pair;
+    MPI_Type_contiguous(2, MPI_DOUBLE, &pair);
+    MPI_Type_commit(&pair);
+
+    size_t errors = 0;
+
+    /* large and small (which is still above the threshold) */
+    MPI_Count counts[2] = { n, m };
+    for (int k=0; k<2; k++) {
+        MPI_Count c = counts[k];
+        int root = size-1;
+
+        /* broadcast */
+        for (MPI_Count i=0; i<c; i++) {
+            rbuf[i] = (rank==root) ? value(i, root) : -1.0;
+        }
+        MPIX_Bcast_x(rbuf, c, MPI_DOUBLE, root, MPI_COMM_WORLD);
+        errors += check(rbuf, c, value, root, rank, "MPIX_Bcast_x");
+
+        /* allgather, with and without MPI_IN_PLACE, and into pairs of doubles */
+        for (MPI_Count i=0; i<c; i++) {
+            sbuf[i] = value(i, rank);
+        }
+        for (int variant=0; variant<3; variant++) {
+            int inplace = (variant==1);
+            int pairs   = (variant==2);
+            MPI_Count rc = pairs ? c/2 : c;
+            MPI_Count sc = pairs ? 2*rc : c;
+            for (MPI_Count i=0; i<sc*size; i++) {
+                rbuf[i] = -1.0;
+            }
+            if (inplace) {
+                memcpy(rbuf+rank*sc, sbuf, (size_t)sc*sizeof(double));
+            }
+            MPIX_Allgather_x(inplace ? MPI_IN_PLACE : sbuf, sc, MPI_DOUBLE,
+                             rbuf, rc, pairs ? pair : MPI_DOUBLE, MPI_COMM_WORLD);
+            for (int r=0; r<size; r++) {
+                errors += check(rbuf+r*sc, sc, value, r, rank,
+                                inplace ? "in-place MPIX_Allgather_x" :
+                                (pairs ? "MPIX_Allgather_x into pairs" : "MPIX_Allgather_x"));
+            }
+        }
+
+        /* allreduce, with and without MPI_IN_PLACE */
+        for (MPI_Count i=0; i<c; i++) {
+            sbuf[i] = (rank+1.)*value(i, 0);
+        }
+        MPIX_Allreduce_x(sbuf, rbuf, c, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        errors += check(rbuf, c, sum, 0, rank, "MPIX_Allreduce_x");
+
+        memcpy(rbuf, sbuf, (size_t)c*sizeof(double));
+        MPIX_Allreduce_x(MPI_IN_PLACE, rbuf, c, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        errors += check(rbuf, c, sum, 0, rank, "in-place MPIX_Allreduce_x");
+    }
+
+    MPI_Type_free(&pair);
+
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+#include "verify_buffer.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+static void my_sum(void * invec, void * inoutvec, int * len, MPI_Datatype * type)
+{
+    (void)type;
+    const double * in = invec;
+    double * inout = inoutvec;
+    for (int i=0; i<*len; i++) {
+        inout[i] += in[i];
+    }
+}
+
+/* a op b = a, which is associative but not commutative: the result is the input of rank 0. */
+static void my_first(void * invec, void * inoutvec, int * len, MPI_Datatype * type)
+{
+    (void)type;
+    memcpy(inoutvec, invec, (size_t)*len*sizeof(double));
+}
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int l = (argc > 1) ? atoi(argv[1]) : 2;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    double * sbuf = NULL;
+    double * rbuf = NULL;
+
+    MPI_Aint bytes = n*sizeof(double);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &rbuf);
+
+    for (MPI_Count i=0; i<n; i++) {
+        sbuf[i] = (double)rank+1.;
+    }
+
+    MPI_Op ops[2];
+    MPIX_Op_create_x(my_sum,   1 /* commute */, &ops[0]);
+    MPIX_Op_create_x(my_first, 0 /* commute */, &ops[1]);
+    const double vals[2] = { (double)size*(size+1.)/2., 1. };
+    const char * names[2] = { "commutative", "non-commutative" };
+
+    size_t errors = 0;
+    for (int k=0; k<2; k++) {
+        size_t e;
+
+        memset(rbuf, 0, (size_t)bytes);
+        MPIX_Allreduce_x(sbuf, rbuf, n, MPI_DOUBLE, ops[k], MPI_COMM_WORLD);
+        e = verify_doubles(rbuf, n, vals[k]);
+        if (e) {
+            printf("%d: %s MPIX_Allreduce_x had %zu errors out of %zu elements!\n", rank, names[k], e, (size_t)n);
+        }
+        errors += e;
+
+        memset(rbuf, 0, (size_t)bytes);
+        MPIX_Reduce_x(sbuf, rbuf, n, MPI_DOUBLE, ops[k], 0 /* root */, MPI_COMM_WORLD);
+        if (rank==0) {
+            e = verify_doubles(rbuf, n, vals[k]);
+            if (e) {
+                printf("%d: %s MPIX_Reduce_x had %zu errors out of %zu elements!\n", rank, names[k], e, (size_t)n);
+            }
+            errors += e;
+        }
+
+        memset(rbuf, 0, (size_t)bytes);
+        MPI_Request req;
+        MPIX_Iallreduce_x(sbuf, rbuf, n, MPI_DOUBLE, ops[k], MPI_COMM_WORLD, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+        e = verify_doubles(rbuf, n, vals[k]);
+        if (e) {
+            printf("%d: %s MPIX_Iallreduce_x had %zu errors out of %zu elements!\n", rank, names[k], e, (size_t)n);
+        }
+        errors += e;
+    }
+
+    MPIX_Op_free_x(&ops[0]);
+    MPIX_Op_free_x(&ops[1]);
+
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+#include "verify_buffer.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+/* Runs every v-collective with n elements per process pair. */
+static size_t test_vcollectives(MPI_Count n, int rank, int size)
+{
+    size_t errors = 0;
+
+    char * buf_send = NULL;
+    char * buf_recv = NULL;
+
+    MPI_Alloc_mem((MPI_Aint)n * size, MPI_INFO_NULL, &buf_send);
+    MPI_Alloc_mem((MPI_Aint)n * size, MPI_INFO_NULL, &buf_recv);
+
+    MPI_Count    * counts = malloc(size*sizeof(MPI_Count));
+    MPI_Aint     * displs = malloc(size*sizeof(MPI_Aint));
+    MPI_Aint     * bdispls = malloc(size*sizeof(MPI_Aint));
+    MPI_Datatype * types  = malloc(size*sizeof(MPI_Datatype));
+    for (int i = 0; i < size; ++i) {
+        counts[i]  = n;
+        displs[i]  = (MPI_Aint)i * n;
+        bdispls[i] = (MPI_Aint)i * n; /* bytes, since the type is MPI_CHAR */
+        types[i]   = MPI_CHAR;
+    }
+
+    int root = size-1;
+
+    /* gatherv */
+    memset(buf_send, rank, (size_t)n);
+    memset(buf_recv, -1,   (size_t)n * size);
+    MPIX_Gatherv_x(buf_send, n, MPI_CHAR, buf_recv, counts, displs, MPI_CHAR, root, MPI_COMM_WORLD);
+    if (rank==root) {
+        for (int i = 0; i < size; ++i) {
+            errors += verify_buffer(buf_recv + i * n, n, i);
+        }
+    }
+
+    /* allgatherv */
+    memset(buf_recv, -1, (size_t)n * size);
+    MPIX_Allgatherv_x(buf_send, n, MPI_CHAR, buf_recv, counts, displs, MPI_CHAR, MPI_COMM_WORLD);
+    for (int i = 0; i < size; ++i) {
+        errors += verify_buffer(buf_recv + i * n, n, i);
+    }
+
+    /* scatterv */
+    for (int i = 0; i < size; ++i) {
+        memset(buf_send + i * n, i+1, (size_t)n);
+    }
+    memset(buf_recv, -1, (size_t)n);
+    MPIX_Scatterv_x(buf_send, counts, displs, MPI_CHAR, buf_recv, n, MPI_CHAR, root, MPI_COMM_WORLD);
+    errors += verify_buffer(buf_recv, n, rank+1);
+
+    /* alltoallv */
+    for (int i = 0; i < size; ++i) {
+        memset(buf_send + i * n, rank*size+i, (size_t)n);
+    }
+    memset(buf_recv, -1, (size_t)n * size);
+    MPIX_Alltoallv_x(buf_send, counts, displs, MPI_CHAR, buf_recv, counts, displs, MPI_CHAR, MPI_COMM_WORLD);
+    for (int i = 0; i < size; ++i) {
+        errors += verify_buffer(buf_recv + i * n, n, i*size+rank);
+    }
+
+    /* alltoallw */
+    memset(buf_recv, -1, (size_t)n * size);
+    MPIX_Alltoallw_x(buf_send, counts, bdispls, types, buf_recv, counts, bdispls, types, MPI_COMM_WORLD);
+    for (int i = 0; i < size; ++i) {
+        errors += verify_buffer(buf_recv + i * n, n, i*size+rank);
+    }
+
+    free(counts);
+    free(displs);
+    free(bdispls);
+    free(types);
+
+    MPI_Free_mem(buf_send);
+    MPI_Free_mem(buf_recv);
+
+    return errors;
+}
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (size<1) {
+        printf("Use 1 or more processes. \n");
+        MPI_Finalize();
+        return 1;
+    }
+
+    int l = (argc > 1) ? atoi(argv[1]) : 2;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    size_t errors = 0;
+
+    /* small counts use the MPI implementation directly, large counts use BigMPI */
+    errors += test_vcollectives(m, rank, size);
+    errors += test_vcollectives(n, rank, size);
+
+    if (errors > 0) {
+        printf("There were %zu errors!\n", errors);
+    }
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
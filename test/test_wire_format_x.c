@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#include <mpi.h>
+#include "bigmpi.h"
+
+/* Yes, it is technically unsafe to cast MPI_Count to MPI_Aint or size_t without checking,
+ * given that MPI_Count might be 128b and MPI_Aint and size_t might be 64b, but BigMPI
+ * does not aspire to support communication of more than 8 EiB messages at a time. */
+
+/* Values that are not representable in a float, let alone a bfloat16. */
+static double value(MPI_Count i, int rank)
+{
+    return 1.0 + (double)((i+rank)%7)/3.0 + (double)rank/1.e3;
+}
+
+/* Checks the n elements of rbuf (doubles or floats) against the sum in double precision
+ * with the error bound of README.md for unit roundoff u and against the result of
+ * rank 0, which has to be exactly the same. */
+static size_t check(const void * rbuf, MPI_Count n, MPI_Datatype type, double u,
+                    int rank, int size, MPI_Comm comm, const char * name)
+{
+    int steps = 0;
+    while ((1<<steps) < size) steps++;
+    double gamma = (steps+1)*u/(1.-(steps+1)*u);
+
+    size_t bytes = (size_t)n*(type==MPI_DOUBLE ? sizeof(double) : sizeof(float));
+    char * ref = NULL;
+    MPI_Alloc_mem(bytes, MPI_INFO_NULL, &ref);
+    if (rank==0) {
+        memcpy(ref, rbuf, bytes);
+    }
+    MPIX_Bcast_x(ref, n, type, 0, comm);
+
+    size_t errors = 0;
+    if (memcmp(ref, rbuf, bytes)!=0) {
+        printf("%d: %s differs from rank 0 (WRONG)\n", rank, name);
+        errors++;
+    }
+    for (MPI_Count i=0; i<n; i++) {
+        double sum = 0.0;
+        for (int r=0; r<size; r++) {
+            sum += (type==MPI_DOUBLE) ? value(i, r) : (float)value(i, r);
+        }
+        /* All values are positive, so the sum is also the sum of the magnitudes. */
+        double x = (type==MPI_DOUBLE) ? ((const double*)rbuf)[i] : ((const float*)rbuf)[i];
+        double diff = (x > sum) ? x-sum : sum-x;
+        if (diff > (gamma+1.e-6)*sum) {
+            printf("%d: %s rbuf[%zu] = %lf (expected %lf - WRONG)\n", rank, name, (size_t)i, x, sum);
+            errors++;
+            break;
+        }
+    }
+
+    MPI_Free_mem(ref);
+    return errors;
+}
+
+int main(int argc, char * argv[])
+{
+    const MPI_Count test_int_max = BigMPI_Get_max_int();
+
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int l = (argc > 1) ? atoi(argv[1]) : 2;
+    int m = (argc > 2) ? atoi(argv[2]) : 17777;
+    MPI_Count n = l * test_int_max + m;
+
+    MPI_Comm comm;
+    MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+
+    double * sbuf = NULL;
+    double * rbuf = NULL;
+    float  * sbuf_f = NULL;
+    float  * rbuf_f = NULL;
+
+    MPI_Alloc_mem(n*sizeof(double), MPI_INFO_NULL, &sbuf);
+    MPI_Alloc_mem(n*sizeof(double), MPI_INFO_NULL, &rbuf);
+    MPI_Alloc_mem(n*sizeof(float),  MPI_INFO_NULL, &sbuf_f);
+    MPI_Alloc_mem(n*sizeof(float),  MPI_INFO_NULL, &rbuf_f);
+
+    for (MPI_Count i=0; i<n; i++) {
+        sbuf[i]   = value(i, rank);
+        sbuf_f[i] = (float)value(i, rank);
+    }
+
+    size_t errors = 0;
+
+    /* large and small */
+    MPI_Count counts[2] = { n, m };
+    for (int k=0; k<2; k++) {
+        MPI_Count c = counts[k];
+
+        MPIX_Comm_set_wire_format_x(comm, MPIX_WIRE_FLOAT);
+        MPIX_Allreduce_x(sbuf, rbuf, c, MPI_DOUBLE, MPI_SUM, comm);
+        errors += check(rbuf, c, MPI_DOUBLE, 1./(1<<24), rank, size, comm, "MPI_DOUBLE as float");
+
+        /* in place */
+        memcpy(rbuf, sbuf, (size_t)c*sizeof(double));
+        MPIX_Allreduce_x(MPI_IN_PLACE, rbuf, c, MPI_DOUBLE, MPI_SUM, comm);
+        errors += check(rbuf, c, MPI_DOUBLE, 1./(1<<24), rank, size, comm, "MPI_DOUBLE as float in place");
+
+        MPIX_Comm_set_wire_format_x(comm, MPIX_WIRE_BFLOAT16);
+        MPIX_Allreduce_x(sbuf, rbuf, c, MPI_DOUBLE, MPI_SUM, comm);
+        errors += check(rbuf, c, MPI_DOUBLE, 1./(1<<8)+1./(1<<24), rank, size, comm, "MPI_DOUBLE as bfloat16");
+
+        MPIX_Allreduce_x(sbuf_f, rbuf_f, c, MPI_FLOAT, MPI_SUM, comm);
+        errors += check(rbuf_f, c, MPI_FLOAT, 1./(1<<8), rank, size, comm, "MPI_FLOAT as bfloat16");
+
+        /* back to full precision, which is not quite exact either */
+        MPIX_Comm_set_wire_format_x(comm, MPIX_WIRE_FULL);
+        MPIX_Allreduce_x(sbuf, rbuf, c, MPI_DOUBLE, MPI_SUM, comm);
+        errors += check(rbuf, c, MPI_DOUBLE, 1.e-15, rank, size, comm, "MPI_DOUBLE");
+    }
+
+    MPI_Free_mem(sbuf);
+    MPI_Free_mem(rbuf);
+    MPI_Free_mem(sbuf_f);
+    MPI_Free_mem(rbuf_f);
+
+    MPI_Comm_free(&comm);
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank==0 && errors==0) {
+        printf("SUCCESS\n");
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}